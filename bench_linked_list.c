@@ -0,0 +1,1203 @@
+#define _GNU_SOURCE  // For the CPU affinity calls of bench_list_numa
+#include "memory_manager.h"
+#include "linked_list.h"
+#include "compact_list.h"
+#include "lockfree.h"
+#include "double_list.h"
+#include "lru_cache.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+#define BENCH_NODES 1000000
+
+// Wall clock time in milliseconds
+static double now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Link count nodes from one pool block into a list with random data. The
+// nodes are carved out of a single mem_alloc so the timings measure the list
+// algorithms rather than per-node allocation.
+static Node *build_random_list(size_t count)
+{
+    Node *nodes = mem_alloc(sizeof(Node) * count);
+    if (nodes == NULL)
+    {
+        printf_red("Failed to allocate %zu benchmark nodes.\n", count);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        nodes[i].data = rand() % 65536;
+        nodes[i].next = (i + 1 < count) ? &nodes[i + 1] : NULL;
+    }
+    return count ? nodes : NULL;
+}
+
+// Check the list is ordered and has the expected length
+static void check_sorted(Node *head, size_t count)
+{
+    size_t n = 0;
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        my_assert(current->next == NULL || current->data <= current->next->data);
+        n++;
+    }
+    my_assert(n == count);
+}
+
+// ********* Sorted operations *********
+
+void bench_list_sort(size_t count)
+{
+    printf_yellow("  Benchmarking list_sort (%zu nodes) ---> ", count);
+    mem_init(sizeof(Node) * count);
+    Node *head = build_random_list(count);
+
+    double start = now_ms();
+    list_sort(&head);
+    double elapsed = now_ms() - start;
+
+    check_sorted(head, count);
+    mem_deinit();
+    printf_green("%.1f ms\n", elapsed);
+}
+
+void bench_list_merge_sorted(size_t count)
+{
+    printf_yellow("  Benchmarking list_merge_sorted (2 x %zu nodes) ---> ", count);
+    mem_init(sizeof(Node) * count * 2);
+    Node *head = build_random_list(count);
+    Node *other = build_random_list(count);
+    list_sort(&head);
+    list_sort(&other);
+
+    double start = now_ms();
+    list_merge_sorted(&head, &other);
+    double elapsed = now_ms() - start;
+
+    check_sorted(head, count * 2);
+    mem_deinit();
+    printf_green("%.1f ms\n", elapsed);
+}
+
+void bench_list_insert_sorted(size_t count)
+{
+    printf_yellow("  Benchmarking list_insert_sorted (%zu nodes) ---> ", count);
+    Node *head = NULL;
+    list_init(&head, count); // list_init scales by sizeof(Node) itself
+
+    double start = now_ms();
+    for (size_t i = 0; i < count; i++)
+    {
+        list_insert_sorted(&head, rand() % 65536);
+    }
+    double elapsed = now_ms() - start;
+
+    check_sorted(head, count);
+    list_cleanup(&head);
+    mem_deinit();
+    printf_green("%.1f ms\n", elapsed);
+}
+
+// ********* Serialization *********
+
+void bench_list_write_fd(size_t count)
+{
+    printf_yellow("  Benchmarking list serialization to /dev/null (%zu nodes) ---> ", count);
+    mem_init(sizeof(Node) * count);
+    Node *head = build_random_list(count);
+    FILE *devnull = fopen("/dev/null", "w");
+    my_assert(devnull != NULL);
+
+    // Reference: one fprintf per element, as list_display used to do
+    double start = now_ms();
+    fprintf(devnull, "[");
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        fprintf(devnull, "%u", current->data);
+        if (current->next != NULL)
+        {
+            fprintf(devnull, ", ");
+        }
+    }
+    fprintf(devnull, "]");
+    fflush(devnull);
+    double printfTime = now_ms() - start;
+
+    start = now_ms();
+    my_assert(list_write_fd(&head, fileno(devnull)) == 0);
+    double writeTime = now_ms() - start;
+
+    size_t len = list_to_buffer(&head, NULL, 0);
+    char *buffer = malloc(len + 1);
+    start = now_ms();
+    list_to_buffer(&head, buffer, len + 1);
+    double bufferTime = now_ms() - start;
+
+    free(buffer);
+    fclose(devnull);
+    mem_deinit();
+    printf_green("fprintf %.1f ms, list_write_fd %.1f ms, list_to_buffer %.1f ms\n", printfTime, writeTime, bufferTime);
+}
+
+void bench_list_save_load(size_t count)
+{
+    printf_yellow("  Benchmarking list_save and list_load (%zu nodes) ---> ", count);
+    const char *path = "bench_list_snapshot.bin";
+    mem_init(sizeof(Node) * count);
+    Node *head = build_random_list(count);
+
+    double start = now_ms();
+    my_assert(list_save(&head, path) == 0);
+    double saveTime = now_ms() - start;
+    mem_deinit();
+
+    start = now_ms();
+    my_assert(list_load(&head, path) == 0);
+    double loadTime = now_ms() - start;
+
+    size_t n = 0;
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        n++;
+    }
+    my_assert(n == count);
+
+    mem_deinit();
+    remove(path);
+    printf_green("save %.1f ms, load %.1f ms\n", saveTime, loadTime);
+}
+
+// ********* Node layout *********
+
+// Visit order for the traversal benchmark: a random permutation, so each hop is a cache miss
+static size_t *random_order(size_t count)
+{
+    size_t *order = malloc(sizeof(size_t) * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+    for (size_t i = count - 1; i > 0; i--)
+    {
+        size_t j = rand() % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    return order;
+}
+
+void bench_compact_traversal(size_t count)
+{
+    printf_yellow("  Benchmarking traversal of Node vs CompactNode lists (%zu nodes) ---> ", count);
+    size_t *order = random_order(count);
+    unsigned long sum = 0;
+
+    mem_init(sizeof(Node) * count);
+    Node *nodes = mem_alloc_batch(count, sizeof(Node));
+    for (size_t i = 0; i < count; i++)
+    {
+        nodes[order[i]].data = i % 65536;
+        nodes[order[i]].next = (i + 1 < count) ? &nodes[order[i + 1]] : NULL;
+    }
+    double start = now_ms();
+    for (Node *current = &nodes[order[0]]; current != NULL; current = current->next)
+    {
+        sum += current->data;
+    }
+    double nodeTime = now_ms() - start;
+    mem_deinit();
+
+    mem_init(sizeof(CompactNode) * count);
+    CompactNode *cnodes = mem_alloc_batch(count, sizeof(CompactNode));
+    for (size_t i = 0; i < count; i++)
+    {
+        cnodes[order[i]].data = i % 65536;
+        cnodes[order[i]].next = (i + 1 < count) ? clist_ref(&cnodes[order[i + 1]]) : NODE_REF_NULL;
+    }
+    start = now_ms();
+    for (NodeRef ref = clist_ref(&cnodes[order[0]]); ref != NODE_REF_NULL; ref = clist_node(ref)->next)
+    {
+        sum -= clist_node(ref)->data;
+    }
+    double compactTime = now_ms() - start;
+    mem_deinit();
+
+    my_assert(sum == 0);
+    free(order);
+    printf_green("Node %.1f ms (%zu MB), CompactNode %.1f ms (%zu MB)\n",
+                 nodeTime, sizeof(Node) * count >> 20, compactTime, sizeof(CompactNode) * count >> 20);
+}
+
+// ********* Concurrency *********
+
+#define READER_LIST_NODES 1000
+#define READER_SEARCHES 20000
+
+pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct
+{
+    Node **head;
+    int useMutex;
+    unsigned int seed;
+} ReaderArgs;
+
+// Exclusive-lock search, the way every reader used to run
+static Node *mutex_search(Node **head, uint16_t data)
+{
+    pthread_mutex_lock(&bench_mutex);
+    Node *current = *head;
+    while (current != NULL && current->data != data)
+    {
+        current = current->next;
+    }
+    pthread_mutex_unlock(&bench_mutex);
+    return current;
+}
+
+static void *reader_worker(void *arg)
+{
+    ReaderArgs *args = arg;
+    for (int i = 0; i < READER_SEARCHES; i++)
+    {
+        uint16_t value = rand_r(&args->seed) % READER_LIST_NODES;
+        Node *found = args->useMutex ? mutex_search(args->head, value) : list_search(args->head, value);
+        my_assert(found != NULL);
+    }
+    return NULL;
+}
+
+// Searches per second with nThreads readers
+static double run_readers(Node **head, int nThreads, int useMutex)
+{
+    pthread_t threads[nThreads];
+    ReaderArgs args[nThreads];
+
+    double start = now_ms();
+    for (int t = 0; t < nThreads; t++)
+    {
+        args[t].head = head;
+        args[t].useMutex = useMutex;
+        args[t].seed = t + 1;
+        pthread_create(&threads[t], NULL, reader_worker, &args[t]);
+    }
+    for (int t = 0; t < nThreads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    double elapsed = now_ms() - start;
+    return nThreads * (double)READER_SEARCHES / (elapsed / 1000.0);
+}
+
+void bench_list_readers()
+{
+    printf_yellow("  Benchmarking concurrent list_search (%d nodes) ... \n", READER_LIST_NODES);
+    mem_init(sizeof(Node) * READER_LIST_NODES);
+    Node *head = build_random_list(READER_LIST_NODES);
+    Node *current = head;
+    for (int i = 0; i < READER_LIST_NODES; i++)
+    {
+        current->data = i;
+        current = current->next;
+    }
+
+    for (int nThreads = 1; nThreads <= 16; nThreads *= 2)
+    {
+        double mutexRate = run_readers(&head, nThreads, 1);
+        double rwlockRate = run_readers(&head, nThreads, 0);
+        printf("\t%2d threads: mutex %8.0f searches/s, rwlock %8.0f searches/s\n", nThreads, mutexRate, rwlockRate);
+    }
+
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+#define CHURN_OPS 20000 // Insert and delete pairs per thread
+
+enum
+{
+    CHURN_IN_LOCK,      // Allocate and free while holding the lock
+    CHURN_OUTSIDE_LOCK, // Same lock, allocate before and free after
+    CHURN_LIST_API      // list_insert_after and list_delete
+};
+
+typedef struct
+{
+    Node **head;
+    int mode;
+    uint16_t value;
+} ChurnArgs;
+
+// Insert and delete the node holding value after the anchor at *head,
+// under bench_mutex, allocating inside or outside the critical sections
+static void churn_mutex(Node **head, uint16_t value, int inLock)
+{
+    Node *node = NULL;
+    if (!inLock)
+    {
+        node = mem_alloc(sizeof(Node));
+    }
+    pthread_mutex_lock(&bench_mutex);
+    if (inLock)
+    {
+        node = mem_alloc(sizeof(Node));
+    }
+    node->data = value;
+    node->next = (*head)->next;
+    (*head)->next = node;
+    pthread_mutex_unlock(&bench_mutex);
+
+    pthread_mutex_lock(&bench_mutex);
+    Node **link = &(*head)->next;
+    while (*link != NULL && (*link)->data != value)
+    {
+        link = &(*link)->next;
+    }
+    Node *found = *link;
+    *link = found->next;
+    if (inLock)
+    {
+        mem_free(found);
+    }
+    pthread_mutex_unlock(&bench_mutex);
+    if (!inLock)
+    {
+        mem_free(found);
+    }
+}
+
+static void *churn_worker(void *arg)
+{
+    ChurnArgs *args = arg;
+    for (int i = 0; i < CHURN_OPS; i++)
+    {
+        if (args->mode == CHURN_LIST_API)
+        {
+            list_insert_after(*args->head, args->value);
+            list_delete(args->head, args->value);
+        }
+        else
+        {
+            churn_mutex(args->head, args->value, args->mode == CHURN_IN_LOCK);
+        }
+    }
+    return NULL;
+}
+
+// Insert and delete pairs per second with nThreads writers
+static double run_churn(Node **head, int nThreads, int mode)
+{
+    pthread_t threads[nThreads];
+    ChurnArgs args[nThreads];
+
+    double start = now_ms();
+    for (int t = 0; t < nThreads; t++)
+    {
+        args[t].head = head;
+        args[t].mode = mode;
+        args[t].value = t + 1; // The anchor holds 0, so every thread deletes its own node
+        pthread_create(&threads[t], NULL, churn_worker, &args[t]);
+    }
+    for (int t = 0; t < nThreads; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    double elapsed = now_ms() - start;
+    return nThreads * (double)CHURN_OPS / (elapsed / 1000.0);
+}
+
+void bench_list_churn()
+{
+    printf_yellow("  Benchmarking concurrent insert and delete ... \n");
+    Node *head;
+    list_init(&head, 64);
+    list_insert(&head, 0);
+
+    for (int nThreads = 1; nThreads <= 16; nThreads *= 2)
+    {
+        double inLockRate = run_churn(&head, nThreads, CHURN_IN_LOCK);
+        double outsideRate = run_churn(&head, nThreads, CHURN_OUTSIDE_LOCK);
+        double listRate = run_churn(&head, nThreads, CHURN_LIST_API);
+        printf("\t%2d threads: alloc inside lock %8.0f pairs/s, outside lock %8.0f pairs/s, list API %8.0f pairs/s\n",
+               nThreads, inLockRate, outsideRate, listRate);
+    }
+
+    list_cleanup(&head);
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+#define QUEUE_ITEMS 20000 // Values sent by each producer
+
+enum
+{
+    QUEUE_LIST,  // list_insert at the tail, list_delete of the head value
+    QUEUE_RING,  // Bounded ring buffer
+    QUEUE_STACK, // Treiber stack
+    QUEUE_MSQ    // Michael-Scott queue
+};
+
+typedef struct
+{
+    int kind;
+    Node **head;
+    RingBuffer *ring;
+    LfStack *stack;
+    LfQueue *queue;
+    int nThreads;
+    size_t *consumed;
+} QueueArgs;
+
+static int queue_push(QueueArgs *args, uint16_t value)
+{
+    switch (args->kind)
+    {
+    case QUEUE_LIST:
+        list_insert(args->head, value);
+        return 0;
+    case QUEUE_RING:
+        return ring_push(args->ring, value);
+    case QUEUE_STACK:
+        return lfstack_push(args->stack, value);
+    default:
+        return lfqueue_enqueue(args->queue, value);
+    }
+}
+
+static int queue_pop(QueueArgs *args, uint16_t *value)
+{
+    switch (args->kind)
+    {
+    case QUEUE_LIST:
+    {
+        // The outer mutex makes reading and deleting the head one step
+        pthread_mutex_lock(&bench_mutex);
+        Node *first = *args->head;
+        if (first != NULL)
+        {
+            *value = first->data;
+            list_delete(args->head, first->data);
+        }
+        pthread_mutex_unlock(&bench_mutex);
+        return first != NULL ? 0 : -1;
+    }
+    case QUEUE_RING:
+        return ring_pop(args->ring, value);
+    case QUEUE_STACK:
+        return lfstack_pop(args->stack, value);
+    default:
+        return lfqueue_dequeue(args->queue, value);
+    }
+}
+
+static void *queue_producer(void *arg)
+{
+    QueueArgs *args = arg;
+    for (int i = 0; i < QUEUE_ITEMS; i++)
+    {
+        while (queue_push(args, i) != 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *queue_consumer(void *arg)
+{
+    QueueArgs *args = arg;
+    size_t total = (size_t)args->nThreads * QUEUE_ITEMS;
+    while (__atomic_load_n(args->consumed, __ATOMIC_RELAXED) < total)
+    {
+        uint16_t value;
+        if (queue_pop(args, &value) == 0)
+        {
+            __atomic_add_fetch(args->consumed, 1, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Values per second through the container with nThreads producers and as many consumers
+static double run_queue(QueueArgs *shared, int kind, int nThreads)
+{
+    pthread_t producers[nThreads], consumers[nThreads];
+    size_t consumed = 0;
+    QueueArgs args = *shared;
+    args.kind = kind;
+    args.nThreads = nThreads;
+    args.consumed = &consumed;
+
+    double start = now_ms();
+    for (int t = 0; t < nThreads; t++)
+    {
+        pthread_create(&consumers[t], NULL, queue_consumer, &args);
+        pthread_create(&producers[t], NULL, queue_producer, &args);
+    }
+    for (int t = 0; t < nThreads; t++)
+    {
+        pthread_join(producers[t], NULL);
+        pthread_join(consumers[t], NULL);
+    }
+    double elapsed = now_ms() - start;
+    return nThreads * (double)QUEUE_ITEMS / (elapsed / 1000.0);
+}
+
+void bench_queue_throughput()
+{
+    printf_yellow("  Benchmarking producer/consumer containers ... \n");
+    Node *head;
+    list_init(&head, 16 * QUEUE_ITEMS * 4);
+    RingBuffer ring;
+    LfStack stack;
+    LfQueue queue;
+    ring_init(&ring, 1024);
+    lfstack_init(&stack);
+    lfqueue_init(&queue);
+    QueueArgs shared = {0, &head, &ring, &stack, &queue, 0, NULL};
+
+    for (int nThreads = 1; nThreads <= 8; nThreads *= 2)
+    {
+        double listRate = run_queue(&shared, QUEUE_LIST, nThreads);
+        double ringRate = run_queue(&shared, QUEUE_RING, nThreads);
+        double stackRate = run_queue(&shared, QUEUE_STACK, nThreads);
+        double msqRate = run_queue(&shared, QUEUE_MSQ, nThreads);
+        printf("\t%d+%d threads: list %8.0f/s, ring %8.0f/s, stack %8.0f/s, queue %8.0f/s\n",
+               nThreads, nThreads, listRate, ringRate, stackRate, msqRate);
+    }
+
+    ring_cleanup(&ring);
+    lfstack_cleanup(&stack);
+    lfqueue_cleanup(&queue);
+    list_cleanup(&head);
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+void bench_dlist_remove(size_t count)
+{
+    printf_yellow("  Benchmarking removal of held nodes (%zu nodes, random order) ---> ", count);
+    size_t *order = random_order(count);
+
+    // Singly linked: the node is known but list_delete has to search for it
+    Node *head;
+    list_init(&head, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        list_insert_sorted(&head, i);
+    }
+    double start = now_ms();
+    for (size_t i = 0; i < count; i++)
+    {
+        list_delete(&head, order[i]);
+    }
+    double singleMs = now_ms() - start;
+    mem_deinit();
+
+    // Doubly linked: unlink the held node directly
+    DList list;
+    dlist_init(&list, count);
+    DNode **nodes = malloc(sizeof(DNode *) * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        nodes[i] = dlist_push_back(&list, i);
+    }
+    start = now_ms();
+    for (size_t i = 0; i < count; i++)
+    {
+        dlist_remove_node(&list, nodes[order[i]]);
+    }
+    double doubleMs = now_ms() - start;
+    my_assert(dlist_count(&list) == 0);
+    dlist_cleanup(&list);
+    mem_deinit();
+
+    free(nodes);
+    free(order);
+    printf("list_delete %.2f ms, dlist_remove_node %.2f ms\n", singleMs, doubleMs);
+}
+
+#define ZIPF_KEYS 50000      // Distinct keys in the trace
+#define ZIPF_ACCESSES 500000 // Length of the trace
+#define LRU_CAPACITY 2000    // Entries the cache holds
+
+// Draw count keys in [0, keys) with P(k) proportional to 1 / (k + 1)^s
+static uint32_t *zipf_trace(size_t keys, size_t count, double s)
+{
+    double *cdf = malloc(sizeof(double) * keys);
+    double total = 0;
+    for (size_t k = 0; k < keys; k++)
+    {
+        total += 1.0 / pow(k + 1, s);
+        cdf[k] = total;
+    }
+
+    uint32_t *trace = malloc(sizeof(uint32_t) * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        double u = (double)rand() / RAND_MAX * total;
+        size_t low = 0, high = keys - 1;
+        while (low < high)
+        {
+            size_t mid = (low + high) / 2;
+            if (cdf[mid] < u)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        // Scatter popular keys so they do not share hash buckets by rank
+        trace[i] = (uint32_t)((low * 40503u) % keys);
+    }
+    free(cdf);
+    return trace;
+}
+
+void bench_lru_zipf()
+{
+    printf_yellow("  Benchmarking LRU caches on a Zipfian trace (%d accesses, %d keys, %d entries) ... \n",
+                  ZIPF_ACCESSES, ZIPF_KEYS, LRU_CAPACITY);
+    uint32_t *trace = zipf_trace(ZIPF_KEYS, ZIPF_ACCESSES, 0.99);
+
+    // Hand-rolled cache: a recency list searched by key
+    DList list;
+    dlist_init(&list, LRU_CAPACITY + 1);
+    size_t listHits = 0;
+    double start = now_ms();
+    for (size_t i = 0; i < ZIPF_ACCESSES; i++)
+    {
+        DNode *node = dlist_search(&list, trace[i]);
+        if (node != NULL)
+        {
+            dlist_move_to_front(&list, node);
+            listHits++;
+            continue;
+        }
+        if (dlist_count(&list) == LRU_CAPACITY)
+        {
+            dlist_remove_node(&list, dlist_last(&list));
+        }
+        dlist_push_front(&list, trace[i]);
+    }
+    double listMs = now_ms() - start;
+    dlist_cleanup(&list);
+    mem_deinit();
+
+    // The cache module: hash lookup and preallocated nodes
+    LruCache cache;
+    lru_init(&cache, LRU_CAPACITY);
+    start = now_ms();
+    for (size_t i = 0; i < ZIPF_ACCESSES; i++)
+    {
+        uint32_t value;
+        if (lru_get(&cache, trace[i], &value) != 0)
+        {
+            lru_put(&cache, trace[i], trace[i]);
+        }
+    }
+    double cacheMs = now_ms() - start;
+    LruStats stats;
+    lru_stats(&cache, &stats);
+    my_assert(stats.hits == listHits); // Same policy, same decisions
+    lru_cleanup(&cache);
+    mem_deinit();
+
+    printf("\tlist based: %.2f ms (%.0f accesses/s)\n", listMs, ZIPF_ACCESSES / (listMs / 1000.0));
+    printf("\tlru_cache:  %.2f ms (%.0f accesses/s), hit rate %.1f%%, %zu evictions\n", cacheMs,
+           ZIPF_ACCESSES / (cacheMs / 1000.0), 100.0 * stats.hits / ZIPF_ACCESSES, stats.evictions);
+    free(trace);
+    printf_green("  ... done.\n");
+}
+
+static int stream_visit(uint16_t data, void *ctx)
+{
+    *(unsigned long *)ctx += data;
+    return 0;
+}
+
+void bench_list_stream(size_t count)
+{
+    printf_yellow("  Benchmarking traversal APIs on %zu scattered nodes ... \n", count);
+    size_t *order = random_order(count);
+
+    // Link the nodes in a random memory order so every step is a cache miss
+    mem_init(sizeof(Node) * count);
+    Node *nodes = mem_alloc_batch(count, sizeof(Node));
+    for (size_t i = 0; i < count; i++)
+    {
+        Node *node = &nodes[order[i]];
+        node->data = rand() % 65536;
+        node->next = (i + 1 < count) ? &nodes[order[i + 1]] : NULL;
+    }
+    Node *head = &nodes[order[0]];
+    double mb = count * sizeof(Node) / (1024.0 * 1024.0);
+
+    // A lock round trip per element
+    unsigned long lockedSum = 0;
+    double start = now_ms();
+    Node *current = head;
+    while (1)
+    {
+        pthread_mutex_lock(&bench_mutex);
+        if (current == NULL)
+        {
+            pthread_mutex_unlock(&bench_mutex);
+            break;
+        }
+        lockedSum += current->data;
+        current = current->next;
+        pthread_mutex_unlock(&bench_mutex);
+    }
+    double lockedMs = now_ms() - start;
+
+    // Raw pointers without any lock
+    unsigned long rawSum = 0;
+    start = now_ms();
+    for (current = head; current != NULL; current = current->next)
+    {
+        rawSum += current->data;
+    }
+    double rawMs = now_ms() - start;
+
+    unsigned long foreachSum = 0;
+    start = now_ms();
+    list_foreach(&head, stream_visit, &foreachSum);
+    double foreachMs = now_ms() - start;
+
+    unsigned long cursorSum = 0;
+    uint16_t batch[256];
+    ListCursor cursor;
+    list_cursor_init(&cursor, &head);
+    start = now_ms();
+    size_t n;
+    while ((n = list_cursor_next_batch(&cursor, batch, 256)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            cursorSum += batch[i];
+        }
+    }
+    double cursorMs = now_ms() - start;
+
+    my_assert(lockedSum == rawSum && foreachSum == rawSum && cursorSum == rawSum);
+    printf("\tlock per node   %8.2f ms (%7.1f MB/s)\n", lockedMs, mb / (lockedMs / 1000.0));
+    printf("\traw, unlocked   %8.2f ms (%7.1f MB/s)\n", rawMs, mb / (rawMs / 1000.0));
+    printf("\tlist_foreach    %8.2f ms (%7.1f MB/s)\n", foreachMs, mb / (foreachMs / 1000.0));
+    printf("\tcursor, 256     %8.2f ms (%7.1f MB/s)\n", cursorMs, mb / (cursorMs / 1000.0));
+
+    free(order);
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+// Load a list of count random values where every node is its own pool block
+// and the list count is set, then relink it in a random order so following
+// next pointers is random access
+static Node *load_scattered_list(size_t count)
+{
+    const char *path = "bench_list_scattered.bin";
+    mem_init(sizeof(Node) * count);
+    Node *head = build_random_list(count);
+    my_assert(list_save(&head, path) == 0);
+    mem_deinit();
+    my_assert(list_load(&head, path) == 0);
+    remove(path);
+
+    Node **nodes = malloc(sizeof(Node *) * count);
+    size_t n = 0;
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        nodes[n++] = current;
+    }
+    size_t *order = random_order(count);
+    // Keep the loaded first node in front, which is where list_load recorded
+    // the list's length, so the pool order paths still apply to it
+    for (size_t i = 0; i < count; i++)
+    {
+        if (order[i] == 0)
+        {
+            order[i] = order[0];
+            order[0] = 0;
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        nodes[order[i]]->next = (i + 1 < count) ? nodes[order[i + 1]] : NULL;
+    }
+    head = nodes[order[0]];
+    free(order);
+    free(nodes);
+    return head;
+}
+
+void bench_list_parallel_reduce(size_t count)
+{
+    printf_yellow("  Benchmarking list_parallel_reduce (%zu nodes) ... \n", count);
+    Node *head = load_scattered_list(count);
+
+    // Single threaded walk of the list computing the same aggregates
+    ListReduction walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.min = UINT16_MAX;
+    double start = now_ms();
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        uint16_t value = current->data;
+        walk.count++;
+        walk.sum += value;
+        if (value < walk.min)
+            walk.min = value;
+        if (value > walk.max)
+            walk.max = value;
+        if (value >= 1000 && value <= 20000)
+            walk.matches++;
+        walk.histogram[value >> 8]++;
+    }
+    double walkMs = now_ms() - start;
+    printf("\tlist walk, 1 thread: %8.2f ms\n", walkMs);
+
+    // The reduction gathers the nodes from the block metadata on one thread
+    // before splitting them, which caps the speedup below
+    void **blocks = malloc(sizeof(void *) * count);
+    my_assert(blocks != NULL);
+    start = now_ms();
+    my_assert(mem_allocated_blocks(blocks, count) == count);
+    double gatherMs = now_ms() - start;
+    free(blocks);
+    printf("\tserial gather from block metadata: %8.2f ms\n", gatherMs);
+
+    double oneThreadMs = 0;
+    for (int nThreads = 1; nThreads <= 16; nThreads *= 2)
+    {
+        ListReduction result;
+        start = now_ms();
+        my_assert(list_parallel_reduce(&head, nThreads, 1000, 20000, &result) == 0);
+        double elapsed = now_ms() - start;
+        if (nThreads == 1)
+            oneThreadMs = elapsed;
+        my_assert(result.sum == walk.sum && result.matches == walk.matches);
+        printf("\tpool order, %2d threads: %8.2f ms, speedup %.2fx over 1 thread, %.2fx over the walk\n",
+               nThreads, elapsed, oneThreadMs / elapsed, walkMs / elapsed);
+    }
+
+    list_parallel_shutdown();
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+void bench_list_pool_scan(size_t count)
+{
+    printf_yellow("  Benchmarking list_pool_scan against list_foreach (%zu nodes) ... \n", count);
+    Node *head = load_scattered_list(count);
+    // Keep one value absent so looking it up visits every node
+    uint16_t missing = 65535;
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        if (current->data == missing)
+            current->data = 0;
+    }
+
+    unsigned long foreachSum = 0;
+    double start = now_ms();
+    my_assert(list_foreach(&head, stream_visit, &foreachSum) == count);
+    double foreachMs = now_ms() - start;
+
+    unsigned long scanSum = 0;
+    start = now_ms();
+    my_assert(list_pool_scan(&head, stream_visit, &scanSum) == count);
+    double scanMs = now_ms() - start;
+    my_assert(scanSum == foreachSum);
+
+    start = now_ms();
+    my_assert(list_search(&head, missing) == NULL);
+    double searchMs = now_ms() - start;
+    start = now_ms();
+    my_assert(!list_contains(&head, missing));
+    double containsMs = now_ms() - start;
+
+    printf("\tlist_foreach, list order:       %8.2f ms\n", foreachMs);
+    printf("\tlist_pool_scan, address order:  %8.2f ms (%.2fx)\n", scanMs, foreachMs / scanMs);
+    printf("\tlist_search of a missing value: %8.2f ms\n", searchMs);
+    printf("\tlist_contains of it:            %8.2f ms (%.2fx)\n", containsMs, searchMs / containsMs);
+
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+void bench_list_relayout(size_t count)
+{
+    printf_yellow("  Benchmarking list_relayout (%zu nodes) ... \n", count);
+    Node *head = load_scattered_list(count);
+
+    unsigned long beforeSum = 0;
+    double disorder = list_disorder(&head);
+    double start = now_ms();
+    list_foreach(&head, stream_visit, &beforeSum);
+    double beforeMs = now_ms() - start;
+
+    start = now_ms();
+    my_assert(list_relayout(&head) == 0);
+    double relayoutMs = now_ms() - start;
+
+    unsigned long afterSum = 0;
+    start = now_ms();
+    list_foreach(&head, stream_visit, &afterSum);
+    double afterMs = now_ms() - start;
+    my_assert(afterSum == beforeSum);
+
+    printf("\tscattered, disorder %.2f: traversal %8.2f ms\n", disorder, beforeMs);
+    printf("\tlist_relayout: %8.2f ms\n", relayoutMs);
+    printf("\trelaid out, disorder %.2f: traversal %8.2f ms (%.2fx)\n",
+           list_disorder(&head), afterMs, beforeMs / afterMs);
+
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+// Build a list of count random values from the region of a NUMA node, linked
+// in a random order so the traversal is bound by memory latency
+static Node *build_node_list(int node, size_t count)
+{
+    my_assert(mem_numa_run_on_node(node) == 0);
+    Node *nodes = build_random_list(count);
+    my_assert(mem_numa_node_of(nodes) == node);
+    size_t *order = random_order(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        nodes[order[i]].next = (i + 1 < count) ? &nodes[order[i + 1]] : NULL;
+    }
+    Node *head = &nodes[order[0]];
+    free(order);
+    return head;
+}
+
+// Best of three traversals of a list
+static double traverse_ms(Node *head, unsigned long *sum)
+{
+    double best = 0;
+    for (int run = 0; run < 3; run++)
+    {
+        *sum = 0;
+        double start = now_ms();
+        for (Node *current = head; current != NULL; current = current->next)
+        {
+            *sum += current->data;
+        }
+        double elapsed = now_ms() - start;
+        if (run == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+void bench_list_numa(size_t count)
+{
+    printf_yellow("  Benchmarking local and remote traversal (%zu nodes per list) ... \n", count);
+    cpu_set_t affinity;
+    sched_getaffinity(0, sizeof(affinity), &affinity);
+
+    // One list in the region of every node, each region with room to spare
+    int nodes = mem_init_numa(1 << 20);
+    mem_deinit();
+    my_assert(mem_init_numa((sizeof(Node) * count + (2 << 20)) * nodes) == nodes);
+    Node *lists[MEM_NUMA_MAX_NODES];
+    for (int node = 0; node < nodes; node++)
+    {
+        lists[node] = build_node_list(node, count);
+    }
+
+    double mb = sizeof(Node) * count / (1024.0 * 1024.0);
+    double localMs = 0, remoteMs = 0;
+    for (int reader = 0; reader < nodes; reader++)
+    {
+        my_assert(mem_numa_run_on_node(reader) == 0);
+        for (int node = 0; node < nodes; node++)
+        {
+            unsigned long sum;
+            double elapsed = traverse_ms(lists[node], &sum);
+            if (node == reader)
+                localMs += elapsed;
+            else
+                remoteMs += elapsed;
+            printf("\tlist on node %d, read from node %d: %8.2f ms (%7.1f MB/s, %5.1f ns per node) %s\n",
+                   node, reader, elapsed, mb / (elapsed / 1000.0), elapsed * 1e6 / count,
+                   node == reader ? "local" : "remote");
+        }
+    }
+
+    localMs /= nodes;
+    printf("\tlocal average:  %8.2f ms (%7.1f MB/s)\n", localMs, mb / (localMs / 1000.0));
+    if (nodes > 1)
+    {
+        remoteMs /= nodes * (nodes - 1);
+        printf("\tremote average: %8.2f ms (%7.1f MB/s, %.2fx slower)\n",
+               remoteMs, mb / (remoteMs / 1000.0), remoteMs / localMs);
+    }
+    else
+    {
+        printf("\tonly one NUMA node, remote traversal not measured\n");
+    }
+
+    sched_setaffinity(0, sizeof(affinity), &affinity);
+    mem_deinit();
+    printf_green("  ... done.\n");
+}
+
+int main(int argc, char *argv[])
+{
+    srand(time(NULL));
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <benchmark>\n", argv[0]);
+        printf("Available benchmarks:\n");
+        printf("Sorted Operations:\n");
+        printf(" 1. bench_list_sort - Merge sort a list of %d random values\n", BENCH_NODES);
+        printf(" 2. bench_list_merge_sorted - Merge two sorted lists of %d values\n", BENCH_NODES);
+        printf(" 3. bench_list_insert_sorted - Build a sorted list with list_insert_sorted\n");
+
+        printf("\nSerialization:\n");
+        printf(" 4. bench_list_write_fd - Compare per-element fprintf with list_write_fd and list_to_buffer\n");
+        printf(" 5. bench_list_save_load - Snapshot a list and map it back in\n");
+
+        printf("\nNode Layout:\n");
+        printf(" 6. bench_compact_traversal - Compare traversal of 16 byte and 8 byte nodes\n");
+
+        printf("\nConcurrency:\n");
+        printf(" 7. bench_list_readers - Reader throughput with 1 to 16 threads\n");
+        printf(" 8. bench_list_churn - Insert and delete throughput with 1 to 16 threads\n");
+        printf(" 9. bench_queue_throughput - Compare the list as a queue with the lock-free containers\n");
+
+        printf("\nDoubly Linked List:\n");
+        printf(" 10. bench_dlist_remove - Remove held nodes with list_delete and dlist_remove_node\n");
+
+        printf("\nCaching:\n");
+        printf(" 11. bench_lru_zipf - Replay a Zipfian trace through a list based cache and lru_cache\n");
+
+        printf("\nTraversal:\n");
+        printf(" 12. bench_list_stream - Compare per-node locking, list_foreach and batched cursors\n");
+        printf(" 13. bench_list_parallel_reduce - Aggregates with 1 to 16 threads\n");
+        printf(" 14. bench_list_pool_scan - Visit elements in pool order instead of list order\n");
+        printf(" 15. bench_list_relayout - Traverse a scattered list before and after list_relayout\n");
+
+        printf("\nNUMA:\n");
+        printf(" 16. bench_list_numa - Traverse lists on the local and on remote NUMA nodes\n");
+        printf(" 0. Run all benchmarks\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case 0:
+        printf("Benchmarking Sorted Operations:\n");
+        bench_list_sort(BENCH_NODES);
+        bench_list_merge_sorted(BENCH_NODES);
+        bench_list_insert_sorted(10000);
+
+        printf("\nBenchmarking Serialization:\n");
+        bench_list_write_fd(BENCH_NODES);
+        bench_list_save_load(BENCH_NODES);
+
+        printf("\nBenchmarking Node Layout:\n");
+        bench_compact_traversal(BENCH_NODES * 8);
+
+        printf("\nBenchmarking Concurrency:\n");
+        bench_list_readers();
+        bench_list_churn();
+        bench_queue_throughput();
+
+        printf("\nBenchmarking Doubly Linked List:\n");
+        bench_dlist_remove(20000);
+
+        printf("\nBenchmarking Caching:\n");
+        bench_lru_zipf();
+
+        printf("\nBenchmarking Traversal:\n");
+        bench_list_stream(BENCH_NODES * 4);
+        bench_list_parallel_reduce(BENCH_NODES * 4);
+        bench_list_pool_scan(BENCH_NODES * 4);
+        bench_list_relayout(BENCH_NODES * 4);
+
+        printf("\nBenchmarking NUMA:\n");
+        bench_list_numa(BENCH_NODES * 4);
+        break;
+    case 1:
+        bench_list_sort(BENCH_NODES);
+        break;
+    case 2:
+        bench_list_merge_sorted(BENCH_NODES);
+        break;
+    case 3:
+        bench_list_insert_sorted(10000);
+        break;
+    case 4:
+        bench_list_write_fd(BENCH_NODES);
+        break;
+    case 5:
+        bench_list_save_load(BENCH_NODES);
+        break;
+    case 6:
+        bench_compact_traversal(BENCH_NODES * 8);
+        break;
+    case 7:
+        bench_list_readers();
+        break;
+    case 8:
+        bench_list_churn();
+        break;
+    case 9:
+        bench_queue_throughput();
+        break;
+    case 10:
+        bench_dlist_remove(20000);
+        break;
+    case 11:
+        bench_lru_zipf();
+        break;
+    case 12:
+        bench_list_stream(BENCH_NODES * 4);
+        break;
+    case 13:
+        bench_list_parallel_reduce(BENCH_NODES * 4);
+        break;
+    case 14:
+        bench_list_pool_scan(BENCH_NODES * 4);
+        break;
+    case 15:
+        bench_list_relayout(BENCH_NODES * 4);
+        break;
+    case 16:
+        bench_list_numa(BENCH_NODES * 4);
+        break;
+    default:
+        printf("Invalid benchmark\n");
+        break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include "memory_manager.h"
+#include "compact_list.h"
+#include "list_format.h"
+#include <pthread.h>
+
+// Mutex for thread-safe compact list operations
+pthread_mutex_t clist_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Number of compact nodes allocated from the pool, across every list in it
+size_t clist_node_count = 0;
+
+// The only list that has held nodes since the pool was created; the node
+// count is its length. Cleared, with clist_pool_shared set, once a second
+// list starts, until the pool has no nodes again. As in linked_list.c.
+NodeRef* clist_pool_owner = NULL;
+int clist_pool_shared = 0;
+
+// Note that the list at head gains nodes, while holding clist_mutex
+static void note_clist_owner(NodeRef* head) {
+    if (clist_pool_owner == NULL && !clist_pool_shared) {
+        clist_pool_owner = head;
+    } else if (clist_pool_owner != head) {
+        clist_pool_owner = NULL;
+        clist_pool_shared = 1;
+    }
+}
+
+// Drop a node from the count, forgetting the owner once the pool has none
+static void drop_clist_node() {
+    if (clist_node_count > 0) clist_node_count--;
+    if (clist_node_count == 0) {
+        clist_pool_owner = NULL;
+        clist_pool_shared = 0;
+    }
+}
+
+// Resolve a reference against the current pool
+CompactNode* clist_node(NodeRef ref) {
+    if (ref == NODE_REF_NULL) return NULL;
+    return (CompactNode*)((char*)mem_pool_base() + ref);
+}
+
+// Turn a node pointer back into a pool offset
+NodeRef clist_ref(CompactNode* node) {
+    if (node == NULL) return NODE_REF_NULL;
+    return (NodeRef)((char*)node - (char*)mem_pool_base());
+}
+
+// Initialize the compact list. Offsets are 32 bits, so the pool is limited to 4 GB.
+void clist_init(NodeRef* head, size_t size) {
+    *head = NODE_REF_NULL;
+    size_t total_pool_size = sizeof(CompactNode) * size;
+    if (total_pool_size >= NODE_REF_NULL) {
+        printf("Error: Compact list pool cannot exceed 4 GB.\n");
+        return;
+    }
+    mem_init(total_pool_size);
+    mem_set_min_block(sizeof(CompactNode));  // A pool sized in nodes splits down to the last one
+    clist_node_count = 0;
+    clist_pool_owner = NULL;
+    clist_pool_shared = 0;
+}
+
+// Allocate and fill a node, returning its reference
+static NodeRef new_node(uint16_t data, NodeRef next) {
+    CompactNode* node = (CompactNode*)mem_alloc(sizeof(CompactNode));
+    if (node == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return NODE_REF_NULL;
+    }
+    node->data = data;
+    node->next = next;
+    clist_node_count++;
+    return clist_ref(node);
+}
+
+// Insert a new node at the end of the list
+void clist_insert(NodeRef* head, uint16_t data) {
+    pthread_mutex_lock(&clist_mutex);  // Lock the mutex
+
+    NodeRef ref = new_node(data, NODE_REF_NULL);
+    if (ref != NODE_REF_NULL) {
+        NodeRef* link = head;
+        while (*link != NODE_REF_NULL) {
+            link = &clist_node(*link)->next;
+        }
+        *link = ref;
+        note_clist_owner(head);
+    }
+
+    pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+}
+
+// Insert a new node after a given node
+void clist_insert_after(NodeRef prev_node, uint16_t data) {
+    pthread_mutex_lock(&clist_mutex);  // Lock the mutex
+
+    if (prev_node == NODE_REF_NULL) {
+        printf("Error: Previous node cannot be NULL.\n");
+        pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+        return;
+    }
+
+    CompactNode* prev = clist_node(prev_node);
+    NodeRef ref = new_node(data, prev->next);
+    if (ref != NODE_REF_NULL) {
+        prev->next = ref;
+    }
+
+    pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+}
+
+// Delete a node with the specified data
+void clist_delete(NodeRef* head, uint16_t data) {
+    pthread_mutex_lock(&clist_mutex);  // Lock the mutex
+
+    NodeRef* link = head;
+    while (*link != NODE_REF_NULL && clist_node(*link)->data != data) {
+        link = &clist_node(*link)->next;
+    }
+
+    if (*link == NODE_REF_NULL) {
+        printf("Error: Node with data %u not found.\n", data);
+        pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+        return;
+    }
+
+    CompactNode* current = clist_node(*link);
+    *link = current->next;
+    mem_free(current);
+    drop_clist_node();
+
+    pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+}
+
+// Search for a node with the specified data
+NodeRef clist_search(NodeRef* head, uint16_t data) {
+    pthread_mutex_lock(&clist_mutex);  // Lock the mutex
+
+    NodeRef ref = *head;
+    while (ref != NODE_REF_NULL && clist_node(ref)->data != data) {
+        ref = clist_node(ref)->next;
+    }
+
+    pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+    return ref;
+}
+
+// Display the list in the same format as list_display
+void clist_display(NodeRef* head) {
+    pthread_mutex_lock(&clist_mutex);  // Lock the mutex
+
+    ListPrinter printer;
+    list_print_begin(&printer);
+    for (NodeRef ref = *head; ref != NODE_REF_NULL; ref = clist_node(ref)->next) {
+        list_print_element(&printer, clist_node(ref)->data, clist_node(ref)->next == NODE_REF_NULL);
+    }
+    list_print_end(&printer);
+
+    pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+}
+
+// Count the nodes in the list, from the node count when the list is the
+// only one in its pool and by walking it otherwise
+int clist_count_nodes(NodeRef* head) {
+    pthread_mutex_lock(&clist_mutex);  // Lock the mutex
+
+    int count = 0;
+    if (*head != NODE_REF_NULL && clist_pool_owner == head) {
+        count = (int)clist_node_count;
+    } else {
+        for (NodeRef ref = *head; ref != NODE_REF_NULL; ref = clist_node(ref)->next) {
+            count++;
+        }
+    }
+
+    pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+    return count;
+}
+
+// Clean up the compact list
+void clist_cleanup(NodeRef* head) {
+    pthread_mutex_lock(&clist_mutex);  // Lock the mutex
+
+    NodeRef ref = *head;
+    while (ref != NODE_REF_NULL) {
+        CompactNode* current = clist_node(ref);
+        ref = current->next;
+        mem_free(current);
+        drop_clist_node();
+    }
+    *head = NODE_REF_NULL;
+
+    pthread_mutex_unlock(&clist_mutex);  // Unlock the mutex
+}
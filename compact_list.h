@@ -0,0 +1,32 @@
+#ifndef COMPACT_LIST_H
+#define COMPACT_LIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+// Reference to a node as a byte offset into the memory pool. Offsets stay
+// valid wherever the pool is mapped, so a compact list can live in a
+// relocated, shared or snapshotted pool.
+typedef uint32_t NodeRef;
+#define NODE_REF_NULL UINT32_MAX
+
+// Struct for nodes in the compact list: 8 bytes instead of the 16 of Node
+typedef struct {
+    NodeRef next;
+    uint16_t data;
+} CompactNode;
+
+void clist_init(NodeRef* head, size_t size);
+void clist_insert(NodeRef* head, uint16_t data);
+void clist_insert_after(NodeRef prev_node, uint16_t data);
+void clist_delete(NodeRef* head, uint16_t data);
+NodeRef clist_search(NodeRef* head, uint16_t data);
+void clist_display(NodeRef* head);
+int clist_count_nodes(NodeRef* head);
+void clist_cleanup(NodeRef* head);
+
+CompactNode* clist_node(NodeRef ref);
+NodeRef clist_ref(CompactNode* node);
+
+#endif // COMPACT_LIST_H
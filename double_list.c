@@ -0,0 +1,224 @@
+#include "memory_manager.h"
+#include "double_list.h"
+#include "list_format.h"
+
+// Initialize the list and a memory pool for size elements
+void dlist_init(DList* list, size_t size) {
+    mem_init(sizeof(DNode) * size);
+
+    pthread_mutex_init(&list->mutex, NULL);
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+}
+
+// Allocate and fill a node before taking the list mutex
+static DNode* new_node(uint16_t data) {
+    DNode* node = (DNode*)mem_alloc(sizeof(DNode));
+    if (node == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return NULL;
+    }
+    node->data = data;
+    node->prev = NULL;
+    node->next = NULL;
+    return node;
+}
+
+// Link node between prev and next; either may be NULL at the ends
+static void link_between(DList* list, DNode* node, DNode* prev, DNode* next) {
+    node->prev = prev;
+    node->next = next;
+    if (prev != NULL) prev->next = node; else list->head = node;
+    if (next != NULL) next->prev = node; else list->tail = node;
+    list->count++;
+}
+
+// Take node out of the list without freeing it
+static void unlink_node(DList* list, DNode* node) {
+    if (node->prev != NULL) node->prev->next = node->next; else list->head = node->next;
+    if (node->next != NULL) node->next->prev = node->prev; else list->tail = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+    list->count--;
+}
+
+// Whether node is linked into list: its neighbours point back at it, or it
+// is the head or tail at an open end. Unlinked nodes have both links
+// cleared, so a second removal of one is caught here.
+static int is_linked(DList* list, DNode* node) {
+    return (node->prev != NULL ? node->prev->next == node : list->head == node) &&
+           (node->next != NULL ? node->next->prev == node : list->tail == node);
+}
+
+// Insert a new node at the front and return it
+DNode* dlist_push_front(DList* list, uint16_t data) {
+    DNode* node = new_node(data);
+    if (node == NULL) return NULL;
+
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    link_between(list, node, NULL, list->head);
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return node;
+}
+
+// Insert a new node at the back and return it
+DNode* dlist_push_back(DList* list, uint16_t data) {
+    DNode* node = new_node(data);
+    if (node == NULL) return NULL;
+
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    link_between(list, node, list->tail, NULL);
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return node;
+}
+
+// Insert a new node after a given node and return it
+DNode* dlist_insert_after(DList* list, DNode* prev_node, uint16_t data) {
+    if (prev_node == NULL) {
+        printf("Error: Previous node cannot be NULL.\n");
+        return NULL;
+    }
+
+    DNode* node = new_node(data);
+    if (node == NULL) return NULL;
+
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    link_between(list, node, prev_node, prev_node->next);
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return node;
+}
+
+// Remove a node the caller holds, e.g. from dlist_search, in O(1).
+// Returns 0 on success and -1 if the node is not in the list, for example
+// because it was removed already.
+int dlist_remove_node(DList* list, DNode* node) {
+    if (node == NULL) {
+        printf("Error: Node cannot be NULL.\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    if (!is_linked(list, node)) {
+        pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+        printf("Error: Node is not in the list.\n");
+        return -1;
+    }
+    unlink_node(list, node);
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+
+    mem_free(node);
+    return 0;
+}
+
+// Move a node to the front, as an LRU cache does on every hit
+void dlist_move_to_front(DList* list, DNode* node) {
+    if (node == NULL) {
+        printf("Error: Node cannot be NULL.\n");
+        return;
+    }
+
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    if (!is_linked(list, node)) {
+        pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+        printf("Error: Node is not in the list.\n");
+        return;
+    }
+    if (list->head != node) {
+        unlink_node(list, node);
+        link_between(list, node, NULL, list->head);
+    }
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+}
+
+// Search for the first node with the specified data
+DNode* dlist_search(DList* list, uint16_t data) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    DNode* current = list->head;
+    while (current != NULL && current->data != data) {
+        current = current->next;
+    }
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return current;
+}
+
+// First node, the start of a forward iteration
+DNode* dlist_first(DList* list) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    DNode* node = list->head;
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return node;
+}
+
+// Last node, the start of a backward iteration
+DNode* dlist_last(DList* list) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    DNode* node = list->tail;
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return node;
+}
+
+// Step to the following node
+DNode* dlist_next(DNode* node) {
+    return node != NULL ? node->next : NULL;
+}
+
+// Step to the preceding node
+DNode* dlist_prev(DNode* node) {
+    return node != NULL ? node->prev : NULL;
+}
+
+// Print the list in the given direction, formatted like list_display
+static void display_nodes(DList* list, int backward) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    DNode* start = backward ? list->tail : list->head;
+
+    ListPrinter printer;
+    list_print_begin(&printer);
+    for (DNode* current = start; current != NULL; current = backward ? current->prev : current->next) {
+        list_print_element(&printer, current->data, (backward ? current->prev : current->next) == NULL);
+    }
+    list_print_end(&printer);
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+}
+
+// Display the list front to back
+void dlist_display(DList* list) {
+    display_nodes(list, 0);
+}
+
+// Display the list back to front
+void dlist_display_reverse(DList* list) {
+    display_nodes(list, 1);
+}
+
+// Count the elements in the list
+size_t dlist_count(DList* list) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    size_t count = list->count;
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return count;
+}
+
+// Clean up the list
+void dlist_cleanup(DList* list) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    DNode* current = list->head;
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+
+    while (current != NULL) {
+        DNode* next = current->next;
+        mem_free(current);
+        current = next;
+    }
+    pthread_mutex_destroy(&list->mutex);
+}
@@ -0,0 +1,41 @@
+#ifndef DOUBLE_LIST_H
+#define DOUBLE_LIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Struct for nodes in the doubly linked list. The back link lets a node be
+// unlinked without searching for its predecessor.
+typedef struct DNode {
+    uint16_t data;
+    struct DNode* prev;
+    struct DNode* next;
+} DNode;
+
+// A list that can be walked in both directions and removes held nodes in O(1)
+typedef struct {
+    DNode* head;
+    DNode* tail;
+    size_t count;          // Number of elements
+    pthread_mutex_t mutex;
+} DList;
+
+void dlist_init(DList* list, size_t size);
+DNode* dlist_push_front(DList* list, uint16_t data);
+DNode* dlist_push_back(DList* list, uint16_t data);
+DNode* dlist_insert_after(DList* list, DNode* prev_node, uint16_t data);
+int dlist_remove_node(DList* list, DNode* node);
+void dlist_move_to_front(DList* list, DNode* node);
+DNode* dlist_search(DList* list, uint16_t data);
+DNode* dlist_first(DList* list);
+DNode* dlist_last(DList* list);
+DNode* dlist_next(DNode* node);
+DNode* dlist_prev(DNode* node);
+void dlist_display(DList* list);
+void dlist_display_reverse(DList* list);
+size_t dlist_count(DList* list);
+void dlist_cleanup(DList* list);
+
+#endif // DOUBLE_LIST_H
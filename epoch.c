@@ -0,0 +1,190 @@
+#include "memory_manager.h"
+#include "epoch.h"
+#include <sched.h>
+
+// Announcement of one registered thread. state is 0 while the thread is
+// outside a critical section and epoch * 2 + 1 while it is inside one.
+typedef struct {
+    unsigned long state;
+    int inUse;
+    char padding[64 - sizeof(unsigned long) - sizeof(int)];  // One slot per cache line
+} EpochSlot;
+
+// Blocks retired during one epoch, waiting to be freed
+typedef struct {
+    void** items;
+    size_t count;
+    size_t capacity;
+    unsigned long epoch;
+    unsigned long generation;   // mem_pool_generation the items belong to
+} LimboBucket;
+
+// Global variables for epoch tracking
+unsigned long globalEpoch = 0;
+EpochSlot epochSlots[EPOCH_MAX_THREADS];
+pthread_key_t epochKey;
+pthread_once_t epochKeyOnce = PTHREAD_ONCE_INIT;
+
+// Per thread state
+static __thread EpochSlot* mySlot = NULL;
+static __thread int myDepth = 0;             // Nesting depth of epoch_enter
+static __thread size_t myRetiredSinceReclaim = 0;
+static __thread LimboBucket myLimbo[3];      // Indexed by epoch % 3
+
+static void release_thread(void* slot);
+
+static void create_key() {
+    pthread_key_create(&epochKey, release_thread);
+}
+
+// Claim an announcement slot for the calling thread
+static EpochSlot* thread_slot() {
+    if (mySlot != NULL) return mySlot;
+
+    pthread_once(&epochKeyOnce, create_key);
+    for (int i = 0; i < EPOCH_MAX_THREADS; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&epochSlots[i].inUse, &expected, 1, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            mySlot = &epochSlots[i];
+            __atomic_store_n(&mySlot->state, 0, __ATOMIC_RELEASE);
+            pthread_setspecific(epochKey, mySlot);
+            return mySlot;
+        }
+    }
+
+    printf("Error: More than %d threads registered for epoch reclamation.\n", EPOCH_MAX_THREADS);
+    exit(1);
+}
+
+// Enter a read side critical section. Calls may nest.
+void epoch_enter() {
+    EpochSlot* slot = thread_slot();
+    if (myDepth++ > 0) return;
+
+    unsigned long epoch = __atomic_load_n(&globalEpoch, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&slot->state, epoch * 2 + 1, __ATOMIC_SEQ_CST);
+}
+
+// Leave a read side critical section
+void epoch_exit() {
+    if (myDepth == 0) {
+        printf("Error: epoch_exit without epoch_enter.\n");
+        return;
+    }
+    if (--myDepth > 0) return;
+
+    __atomic_store_n(&mySlot->state, 0, __ATOMIC_RELEASE);
+}
+
+// Move the global epoch forward if every active thread has seen the current one
+static void try_advance() {
+    unsigned long epoch = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < EPOCH_MAX_THREADS; i++) {
+        if (!__atomic_load_n(&epochSlots[i].inUse, __ATOMIC_ACQUIRE)) continue;
+
+        unsigned long state = __atomic_load_n(&epochSlots[i].state, __ATOMIC_SEQ_CST);
+        if ((state & 1) && (state >> 1) != epoch) return;
+    }
+    __atomic_compare_exchange_n(&globalEpoch, &epoch, epoch + 1, 0,
+                                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+// Return a bucket to the pool in one batch. Blocks retired from a pool that
+// has since been deinitialized are dropped, they must not be freed into the
+// pool that replaced it.
+static void free_bucket(LimboBucket* bucket) {
+    if (bucket->count == 0) return;
+    if (bucket->generation == mem_pool_generation()) {
+        mem_free_batch(bucket->items, bucket->count);
+    }
+    bucket->count = 0;
+}
+
+// Free this thread's buckets that no reader can still reach. A block retired
+// in epoch e is safe once the global epoch reaches e + 2.
+static void reclaim_buckets() {
+    unsigned long epoch = __atomic_load_n(&globalEpoch, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < 3; i++) {
+        if (myLimbo[i].count > 0 && myLimbo[i].epoch + 2 <= epoch) {
+            free_bucket(&myLimbo[i]);
+        }
+    }
+}
+
+// Free ptr once no thread inside a critical section can still be using it
+void mem_retire(void* ptr) {
+    if (ptr == NULL) return;
+    thread_slot();
+
+    unsigned long epoch = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+    LimboBucket* bucket = &myLimbo[epoch % 3];
+    if (bucket->epoch != epoch) {
+        // The bucket holds blocks from at least three epochs ago
+        free_bucket(bucket);
+        bucket->epoch = epoch;
+    }
+    if (bucket->count > 0 && bucket->generation != mem_pool_generation()) {
+        free_bucket(bucket);
+    }
+    bucket->generation = mem_pool_generation();
+
+    if (bucket->count == bucket->capacity) {
+        size_t newCapacity = bucket->capacity ? bucket->capacity * 2 : EPOCH_BATCH;
+        void** grown = realloc(bucket->items, newCapacity * sizeof(void*));
+        if (grown == NULL) {
+            printf("Error: Failed to grow retire list.\n");
+            exit(1);
+        }
+        bucket->items = grown;
+        bucket->capacity = newCapacity;
+    }
+    bucket->items[bucket->count++] = ptr;
+
+    if (++myRetiredSinceReclaim >= EPOCH_BATCH) {
+        epoch_reclaim();
+    }
+}
+
+// Try to advance the epoch and free whatever this thread retired that is now
+// safe. Never blocks.
+void epoch_reclaim() {
+    myRetiredSinceReclaim = 0;
+    try_advance();
+    reclaim_buckets();
+}
+
+// Wait until every block this thread retired has been freed. Must not be
+// called inside a critical section.
+void epoch_synchronize() {
+    if (myDepth > 0) {
+        printf("Error: epoch_synchronize inside a critical section.\n");
+        return;
+    }
+
+    unsigned long target = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST) + 2;
+    while (__atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST) < target) {
+        try_advance();
+        if (__atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST) < target) sched_yield();
+    }
+    for (int i = 0; i < 3; i++) {
+        free_bucket(&myLimbo[i]);
+    }
+    myRetiredSinceReclaim = 0;
+}
+
+// Thread exit: flush the thread's retired blocks and give up its slot
+static void release_thread(void* slot) {
+    mySlot = slot;
+    myDepth = 0;
+    epoch_synchronize();
+
+    for (int i = 0; i < 3; i++) {
+        free(myLimbo[i].items);
+        myLimbo[i].items = NULL;
+        myLimbo[i].capacity = 0;
+    }
+    __atomic_store_n(&mySlot->state, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&mySlot->inUse, 0, __ATOMIC_RELEASE);
+    mySlot = NULL;
+}
@@ -0,0 +1,22 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stddef.h>
+
+// Epoch based reclamation for data structures built on the memory pool.
+//
+// Readers bracket every access to shared blocks with epoch_enter and
+// epoch_exit. A writer that unlinks a block hands it to mem_retire instead
+// of mem_free; the block goes back to the pool once every thread that might
+// still hold a pointer to it has left its critical section.
+
+#define EPOCH_MAX_THREADS 64 // Threads that can be registered at once
+#define EPOCH_BATCH 64       // Retired blocks between reclamation attempts
+
+void epoch_enter();
+void epoch_exit();
+void mem_retire(void* ptr);
+void epoch_reclaim();
+void epoch_synchronize();
+
+#endif // EPOCH_H
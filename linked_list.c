@@ -1,75 +1,376 @@
+#define _GNU_SOURCE  // For the writer preferring rwlock initializer
 #include "memory_manager.h"
 #include "linked_list.h"
+#include "list_format.h"
 #include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
-// Mutex for thread-safe linked list operations
-pthread_mutex_t list_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Lock for thread-safe linked list operations. Searches, display and
+// serialization only read the list, so they share the lock and run in
+// parallel; inserts and deletes take it exclusively. Writers are preferred
+// where available so a steady stream of readers cannot starve them.
+#ifdef PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+pthread_rwlock_t list_lock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+#else
+pthread_rwlock_t list_lock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+
+// Number of list nodes allocated from the pool, across every list in it
+size_t list_node_count = 0;
+
+// Bumped under the write lock whenever nodes are unlinked, freed or
+// reordered, so a reader that dropped the lock can tell whether a node it
+// saved is still where it left it. Inserts leave saved nodes in place.
+unsigned long list_version = 0;
+
+// Length of each list, keyed by its first node so every copy of a head
+// pointer finds the same entry; empty lists have none. Open addressing with
+// linear probing, guarded by list_lock and tied to one pool by its
+// mem_pool_generation. list_insert_after has no head to find its list by,
+// so with several lists in the pool it marks every length stale, and the
+// next list_count_nodes of each list walks it once.
+typedef struct {
+    Node* first;    // NULL for an empty slot
+    size_t count;
+    int stale;
+} ListLength;
+
+ListLength* list_lengths = NULL;
+size_t list_lengths_mask = 0;       // Capacity - 1; the capacity is a power of two
+size_t list_lengths_used = 0;
+unsigned long list_lengths_generation = 0;
+
+static size_t length_slot(Node* first) {
+    return (size_t)((uintptr_t)first * 0x9e3779b97f4a7c15ull >> 17) & list_lengths_mask;
+}
+
+// Entry of the list starting at first, or NULL if it has none
+static ListLength* find_length(Node* first) {
+    if (first == NULL || list_lengths == NULL || list_lengths_generation != mem_pool_generation()) return NULL;
+    for (size_t i = length_slot(first); list_lengths[i].first != NULL; i = (i + 1) & list_lengths_mask) {
+        if (list_lengths[i].first == first) return &list_lengths[i];
+    }
+    return NULL;
+}
+
+// Remove the entry of the list starting at first into *out. Returns 0 if
+// there was none.
+static int take_length(Node* first, ListLength* out) {
+    ListLength* entry = find_length(first);
+    if (entry == NULL) return 0;
+    *out = *entry;
+
+    // Shift later entries of the probe run back over the hole
+    size_t hole = (size_t)(entry - list_lengths);
+    for (size_t j = (hole + 1) & list_lengths_mask; list_lengths[j].first != NULL; j = (j + 1) & list_lengths_mask) {
+        size_t home = length_slot(list_lengths[j].first);
+        int between = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!between) {
+            list_lengths[hole] = list_lengths[j];
+            hole = j;
+        }
+    }
+    list_lengths[hole].first = NULL;
+    list_lengths_used--;
+    return 1;
+}
+
+// Record the length of the list starting at first. If the table cannot grow
+// the list goes without an entry and is walked when counted.
+static void put_length(Node* first, size_t count, int stale) {
+    if (first == NULL) return;
+    if (list_lengths_generation != mem_pool_generation()) {
+        // Lists of an earlier pool are gone
+        if (list_lengths != NULL) memset(list_lengths, 0, (list_lengths_mask + 1) * sizeof(ListLength));
+        list_lengths_used = 0;
+        list_lengths_generation = mem_pool_generation();
+    }
+
+    ListLength* entry = find_length(first);
+    if (entry == NULL && (list_lengths_used + 1) * 2 > list_lengths_mask + 1) {
+        size_t capacity = list_lengths != NULL ? (list_lengths_mask + 1) * 2 : 16;
+        ListLength* grown = calloc(capacity, sizeof(ListLength));
+        if (grown == NULL) return;
+
+        ListLength* old = list_lengths;
+        size_t oldCapacity = old != NULL ? list_lengths_mask + 1 : 0;
+        list_lengths = grown;
+        list_lengths_mask = capacity - 1;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (old[i].first == NULL) continue;
+            size_t j = length_slot(old[i].first);
+            while (list_lengths[j].first != NULL) j = (j + 1) & list_lengths_mask;
+            list_lengths[j] = old[i];
+        }
+        free(old);
+    }
+    if (entry == NULL) {
+        size_t i = length_slot(first);
+        while (list_lengths[i].first != NULL) i = (i + 1) & list_lengths_mask;
+        entry = &list_lengths[i];
+        entry->first = first;
+        list_lengths_used++;
+    }
+    entry->count = count;
+    entry->stale = stale;
+}
+
+// Change the length of the list starting at first by delta
+static void add_length(Node* first, long delta) {
+    ListLength* entry = find_length(first);
+    if (entry != NULL) entry->count += delta;
+}
+
+// Move the length of a list whose first node changed from from to to, and
+// change it by delta. A list that was empty starts at delta.
+static void move_length(Node* from, Node* to, long delta) {
+    ListLength entry = { from, 0, 0 };
+    if (from != NULL && !take_length(from, &entry)) return;
+    put_length(to, entry.count + delta, entry.stale);
+}
+
+// Whether every list node in the pool belongs to the list at head, so that
+// pool order shortcuts may be used for it
+static int owns_pool(Node** head) {
+    ListLength* entry = find_length(*head);
+    return entry != NULL && !entry->stale && entry->count == list_node_count;
+}
 
 // Initialize the linked list
 void list_init(Node** head, size_t size) {
     *head = NULL;
     size_t total_pool_size = sizeof(Node) * size;
     mem_init(total_pool_size);
+    list_node_count = 0;
 }
 
-// Insert a new node
-void list_insert(Node** head, uint16_t data) {
-    pthread_mutex_lock(&list_mutex);  // Lock the mutex
-
-    Node* new_node = (Node*)mem_alloc(sizeof(Node));
-    if (new_node == NULL) {
+// Allocate and fill a node before taking list_lock. The pool has its own
+// lock, so allocating here keeps the list's critical sections down to the
+// pointer updates; likewise unlinked nodes are freed after list_lock is
+// released.
+static Node* new_node_unlocked(uint16_t data) {
+    Node* node = (Node*)mem_alloc(sizeof(Node));
+    if (node == NULL) {
         printf("Error: Memory allocation failed.\n");
-        pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
-        return;
+        return NULL;
     }
+    node->data = data;
+    node->next = NULL;
+    return node;
+}
+
+// Insert a new node
+void list_insert(Node** head, uint16_t data) {
+    Node* new_node = new_node_unlocked(data);
+    if (new_node == NULL) return;
 
-    new_node->data = data;
-    new_node->next = NULL;
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
 
+    size_t length = 0;
     if (*head == NULL) {
         *head = new_node;
     } else {
         Node* current = *head;
+        length++;
         while (current->next != NULL) {
             current = current->next;
+            length++;
         }
         current->next = new_node;
     }
+    list_node_count++;
+    put_length(*head, length + 1, 0);  // The walk to the tail counted the list
 
-    pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
 }
 
 // Insert a new node after a given node
 void list_insert_after(Node* prev_node, uint16_t data) {
-    pthread_mutex_lock(&list_mutex);  // Lock the mutex
-
     if (prev_node == NULL) {
         printf("Error: Previous node cannot be NULL.\n");
-        pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
         return;
     }
 
-    Node* new_node = (Node*)mem_alloc(sizeof(Node));
-    if (new_node == NULL) {
-        printf("Error: Memory allocation failed.\n");
-        pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
-        return;
-    }
+    Node* new_node = new_node_unlocked(data);
+    if (new_node == NULL) return;
+
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
 
-    new_node->data = data;
     new_node->next = prev_node->next;
     prev_node->next = new_node;
+    list_node_count++;
+    if (list_lengths_used == 1 && list_lengths_generation == mem_pool_generation()) {
+        // The only list in the pool holds prev_node
+        for (size_t i = 0; i <= list_lengths_mask; i++) {
+            if (list_lengths[i].first != NULL) list_lengths[i].count++;
+        }
+    } else {
+        for (size_t i = 0; list_lengths != NULL && i <= list_lengths_mask; i++) {
+            list_lengths[i].stale = 1;
+        }
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+}
+
+// Insert a new node before a given node
+void list_insert_before(Node** head, Node* next_node, uint16_t data) {
+    if (next_node == NULL) {
+        printf("Error: Next node cannot be NULL.\n");
+        return;
+    }
+
+    Node* new_node = new_node_unlocked(data);
+    if (new_node == NULL) return;
+
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+
+    // Walk the links rather than the nodes so the head needs no special case
+    Node** link = head;
+    while (*link != NULL && *link != next_node) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+        printf("Error: Next node not found in list.\n");
+        mem_free(new_node);
+        return;
+    }
+
+    new_node->next = next_node;
+    *link = new_node;
+    list_node_count++;
+    if (link == head) {
+        move_length(next_node, new_node, 1);
+    } else {
+        add_length(*head, 1);
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+}
+
+// Insert a new node before the first node with larger data, keeping the list ordered
+void list_insert_sorted(Node** head, uint16_t data) {
+    Node* new_node = new_node_unlocked(data);
+    if (new_node == NULL) return;
+
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+
+    // Equal values keep their insertion order
+    Node** link = head;
+    while (*link != NULL && (*link)->data <= data) {
+        link = &(*link)->next;
+    }
+    new_node->next = *link;
+    *link = new_node;
+    list_node_count++;
+    if (link == head) {
+        move_length(new_node->next, new_node, 1);
+    } else {
+        add_length(*head, 1);
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+}
+
+// Merge two sorted chains. Nodes from a come first on equal data, which keeps the sort stable.
+static Node* merge_runs(Node* a, Node* b, Node** tail) {
+    Node dummy;
+    Node* last = &dummy;
+
+    while (a != NULL && b != NULL) {
+        if (b->data < a->data) {
+            last->next = b;
+            b = b->next;
+        } else {
+            last->next = a;
+            a = a->next;
+        }
+        last = last->next;
+    }
+    last->next = (a != NULL) ? a : b;
 
-    pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
+    if (tail != NULL) {
+        while (last->next != NULL) {
+            last = last->next;
+        }
+        *tail = last;
+    }
+    return dummy.next;
+}
+
+// Cut the chain after its first n nodes and return the remainder
+static Node* split_run(Node* head, size_t n) {
+    for (size_t i = 1; head != NULL && i < n; i++) {
+        head = head->next;
+    }
+    if (head == NULL) return NULL;
+
+    Node* rest = head->next;
+    head->next = NULL;
+    return rest;
+}
+
+// Sort the list in place with a bottom-up merge sort. Runs are relinked, no memory is allocated.
+void list_sort(Node** head) {
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+    list_version++;
+
+    size_t length = 0;
+    for (Node* current = *head; current != NULL; current = current->next) {
+        length++;
+    }
+
+    Node dummy;
+    dummy.next = *head;
+    for (size_t width = 1; width < length; width *= 2) {
+        Node* current = dummy.next;
+        Node* tail = &dummy;
+
+        while (current != NULL) {
+            Node* left = current;
+            Node* right = split_run(left, width);
+            current = split_run(right, width);
+            tail->next = merge_runs(left, right, &tail);
+        }
+    }
+    move_length(*head, dummy.next, 0);
+    *head = dummy.next;
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+}
+
+// Merge the sorted list other into the sorted list head. other is left empty.
+void list_merge_sorted(Node** head, Node** other) {
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+    list_version++;
+
+    if (head != other) {
+        ListLength mine = { NULL, 0, 0 };
+        ListLength theirs = { NULL, 0, 0 };
+        // A non-empty list without an entry has an unknown length
+        int known = (*head == NULL || take_length(*head, &mine)) &&
+                    (*other == NULL || take_length(*other, &theirs));
+
+        *head = merge_runs(*head, *other, NULL);
+        *other = NULL;
+        put_length(*head, mine.count + theirs.count, !known || mine.stale || theirs.stale);
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
 }
 
 // Delete a node with the specified data
 void list_delete(Node** head, uint16_t data) {
-    pthread_mutex_lock(&list_mutex);  // Lock the mutex
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+    list_version++;
 
     if (*head == NULL) {
         printf("Error: List is empty.\n");
-        pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
+        pthread_rwlock_unlock(&list_lock);  // Unlock the lock
         return;
     }
 
@@ -83,66 +384,829 @@ void list_delete(Node** head, uint16_t data) {
 
     if (current == NULL) {
         printf("Error: Node with data %u not found.\n", data);
-        pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
+        pthread_rwlock_unlock(&list_lock);  // Unlock the lock
         return;
     }
 
     if (previous == NULL) {
         *head = current->next;
+        move_length(current, current->next, -1);
     } else {
         previous->next = current->next;
+        add_length(*head, -1);
     }
+    if (list_node_count > 0) list_node_count--;
 
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
     mem_free(current);
-    pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
 }
 
 // Search for a node with the specified data
 Node* list_search(Node** head, uint16_t data) {
-    pthread_mutex_lock(&list_mutex);  // Lock the mutex
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
 
     Node* current = *head;
     while (current != NULL) {
         if (current->data == data) {
-            pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
+            pthread_rwlock_unlock(&list_lock);  // Unlock the lock
             return current;
         }
         current = current->next;
     }
 
-    pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
     return NULL;
 }
 
+// Format the nodes from start to end inclusive as "[a, b, c]". Writes at most
+// cap bytes and returns the full length, so a short buffer can be retried.
+static size_t format_range(Node* start, Node* end, char* buf, size_t cap) {
+    char element[LIST_MAX_ELEMENT_CHARS];
+    size_t len = 0;
+
+    if (len < cap) buf[len] = '[';
+    len++;
+
+    for (Node* current = start; current != NULL; current = current->next) {
+        size_t n = list_format_u16(element, current->data);
+        int last = (current == end || current->next == NULL);
+        if (!last) {
+            element[n++] = ',';
+            element[n++] = ' ';
+        }
+
+        if (len + n <= cap) {
+            memcpy(buf + len, element, n);
+        } else if (len < cap) {
+            memcpy(buf + len, element, cap - len);
+        }
+        len += n;
+
+        if (last) break;
+    }
+
+    if (len < cap) buf[len] = ']';
+    len++;
+    return len;
+}
+
+// Called by stream_range with each formatted chunk; returns 0 to go on
+typedef int (*flush_fn)(const char* buf, size_t len, void* ctx);
+
+// Stream the nodes from start_node to end_node inclusive as "[a, b, c]"
+// through buf, cap bytes at a time, handing each chunk to flush. The read
+// lock is held only while a chunk is formatted, so flush never holds off
+// writers. The next chunk resumes at the node where formatting stopped; if
+// nodes were unlinked or reordered in between, the position is found again
+// by walking from the head, and a range whose start_node is gone ends there.
+// Returns 0, or -1 if flush failed.
+static int stream_range(Node** head, Node* start_node, Node* end_node, char* buf, size_t cap,
+                        flush_fn flush, void* ctx) {
+    Node* next = NULL;
+    size_t emitted = 0;
+    unsigned long version = 0;
+    unsigned long generation = 0;
+    int started = 0;
+    int finished = 0;
+
+    while (!finished) {
+        size_t len = 0;
+        pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+        Node* current = next;
+        if (!started) {
+            current = (start_node != NULL) ? start_node : *head;
+            buf[len++] = '[';
+            started = 1;
+        } else if (version != list_version || generation != mem_pool_generation()) {
+            current = *head;
+            while (start_node != NULL && current != NULL && current != start_node) {
+                current = current->next;
+            }
+            for (size_t i = 0; current != NULL && i < emitted; i++) {
+                // Past the end of the range, which has been written already
+                current = (current == end_node) ? NULL : current->next;
+            }
+        }
+
+        // Whole elements only, leaving room for the closing bracket
+        while (current != NULL && len + LIST_MAX_ELEMENT_CHARS + 1 <= cap) {
+            len += list_format_u16(buf + len, current->data);
+            emitted++;
+            if (current == end_node || current->next == NULL) {
+                current = NULL;
+                break;
+            }
+            buf[len++] = ',';
+            buf[len++] = ' ';
+            current = current->next;
+        }
+        if (current == NULL) {
+            buf[len++] = ']';
+            finished = 1;
+        }
+        next = current;
+        version = list_version;
+        generation = mem_pool_generation();
+
+        pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+
+        if (flush(buf, len, ctx) != 0) return -1;
+    }
+    return 0;
+}
+
+static int flush_stdout(const char* buf, size_t len, void* ctx) {
+    (void)ctx;
+    return fwrite(buf, 1, len, stdout) == len ? 0 : -1;
+}
+
+// Display the range a stack buffer at a time, calling into stdio unlocked
+static void display_nodes(Node** head, Node* start_node, Node* end_node) {
+    char buf[4096];
+    stream_range(head, start_node, end_node, buf, sizeof(buf), flush_stdout, NULL);
+}
+
 // Display the list
 void list_display(Node** head) {
-    pthread_mutex_lock(&list_mutex);  // Lock the mutex
+    display_nodes(head, NULL, NULL);
+}
 
-    Node* current = *head;
-    printf("[");
-    while (current != NULL) {
-        printf("%u", current->data);
-        if (current->next != NULL) {
-            printf(", ");
+// Display the nodes from start_node to end_node inclusive. A NULL start_node
+// starts at the head and a NULL end_node runs to the end of the list.
+void list_display_range(Node** head, Node* start_node, Node* end_node) {
+    display_nodes(head, start_node, end_node);
+}
+
+// Format the list into buf like snprintf: the output is truncated to cap - 1
+// characters and NUL terminated, and the untruncated length is returned.
+size_t list_to_buffer(Node** head, char* buf, size_t cap) {
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    size_t len = format_range(*head, NULL, buf, cap ? cap - 1 : 0);
+    if (cap > 0) buf[len < cap ? len : cap - 1] = '\0';
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    return len;
+}
+
+// Write all of buf to fd, retrying on partial writes
+static int write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
         }
+        buf += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+static int flush_fd(const char* buf, size_t len, void* ctx) {
+    return write_all(*(int*)ctx, buf, len);
+}
+
+// Write the list to a file descriptor with one write per 64KB chunk. Each
+// chunk is formatted under the read lock and written after it is released,
+// so a slow fd does not hold off writers and no memory is allocated.
+// Returns 0 on success and -1 if a write failed.
+int list_write_fd(Node** head, int fd) {
+    char buf[65536];
+    int result = stream_range(head, NULL, NULL, buf, sizeof(buf), flush_fd, &fd);
+
+    if (result != 0) printf("Error: Failed to write list to fd %d.\n", fd);
+    return result;
+}
+
+#define LIST_FILE_MAGIC 0x31534C4C  // "LLS1"
+
+// Header of a list snapshot. The node image that follows at data_offset is
+// a pool image: nodes are stored in list order from offset 0 and each next
+// field holds the offset of the following node plus one (0 for NULL), so the
+// file does not depend on where the pool was mapped.
+typedef struct {
+    uint32_t magic;
+    uint32_t node_size;
+    uint64_t count;
+    uint64_t data_offset;  // Page aligned start of the node image
+    uint64_t pool_size;    // Pool capacity; the image is zero padded up to it
+} ListFileHeader;
+
+// Save the list to path. Returns 0 on success and -1 on error.
+int list_save(Node** head, const char* path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Error: Failed to open %s for writing.\n", path);
+        return -1;
+    }
+
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    size_t count = 0;
+    for (Node* current = *head; current != NULL; current = current->next) {
+        count++;
+    }
+
+    ListFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LIST_FILE_MAGIC;
+    header.node_size = sizeof(Node);
+    header.count = count;
+    header.data_offset = sysconf(_SC_PAGESIZE);
+    header.pool_size = mem_pool_size();
+    if (header.pool_size < count * sizeof(Node)) header.pool_size = count * sizeof(Node);
+
+    int result = write_all(fd, (const char*)&header, sizeof(header));
+    if (result == 0 && lseek(fd, header.data_offset, SEEK_SET) < 0) result = -1;
+
+    // Stream the nodes through a buffer, swizzling next pointers to offsets.
+    // The buffer is zeroed so struct padding does not carry stack bytes to disk.
+    Node buffer[4096];
+    memset(buffer, 0, sizeof(buffer));
+    size_t n = 0;
+    size_t index = 0;
+    for (Node* current = *head; current != NULL && result == 0; current = current->next) {
+        buffer[n].data = current->data;
+        buffer[n].next = (current->next != NULL) ? (Node*)(uintptr_t)((index + 1) * sizeof(Node) + 1) : NULL;
+        index++;
+        if (++n == sizeof(buffer) / sizeof(buffer[0])) {
+            result = write_all(fd, (const char*)buffer, sizeof(buffer));
+            n = 0;
+        }
+    }
+    if (result == 0) result = write_all(fd, (const char*)buffer, n * sizeof(Node));
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+
+    // Extend to the full pool size; the padding is a hole and takes no disk space
+    if (result == 0) result = ftruncate(fd, header.data_offset + header.pool_size);
+    if (close(fd) != 0) result = -1;
+
+    if (result != 0) printf("Error: Failed to save list to %s.\n", path);
+    return result;
+}
+
+// Check that the links of a loaded image, still in offset form, lead from
+// node 0 through each of the count nodes exactly once to a NULL. Rejects
+// links out of range, cycles, and nodes linked twice or not at all.
+// Returns 0 if so, -1 if not and 1 if memory ran out.
+static int check_links(Node* nodes, size_t count) {
+    unsigned char* seen = calloc(count, 1);
+    if (seen == NULL) return 1;
+
+    size_t limit = count * sizeof(Node);
+    size_t index = 0;
+    size_t visited = 0;
+    int valid = 0;
+    while (!seen[index]) {
+        seen[index] = 1;
+        visited++;
+        uintptr_t offset = (uintptr_t)nodes[index].next;
+        if (offset == 0) {
+            valid = visited == count;
+            break;
+        }
+        if (offset > limit || (offset - 1) % sizeof(Node) != 0) break;
+        index = (offset - 1) / sizeof(Node);
+    }
+
+    free(seen);
+    return valid ? 0 : -1;
+}
+
+// Load a list saved by list_save. Like list_init this starts a new memory
+// pool; the pool is mapped straight from the file, so only the next fields
+// are rewritten. Returns 0 on success and -1 on error.
+int list_load(Node** head, const char* path) {
+    *head = NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Failed to open %s for reading.\n", path);
+        return -1;
+    }
+
+    // The image must fit the pool and the pool must lie within the file
+    ListFileHeader header;
+    struct stat st;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || fstat(fd, &st) != 0
+        || header.magic != LIST_FILE_MAGIC || header.node_size != sizeof(Node)
+        || header.count > header.pool_size / sizeof(Node)
+        || header.data_offset > (uint64_t)st.st_size
+        || header.pool_size > (uint64_t)st.st_size - header.data_offset) {
+        printf("Error: %s is not a list snapshot.\n", path);
+        close(fd);
+        return -1;
+    }
+
+    int result = mem_init_mapped(fd, header.data_offset, header.pool_size);
+    close(fd);  // The mapping keeps the file contents alive
+    if (result != 0) return -1;
+
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+    list_version++;
+
+    list_node_count = 0;
+    if (header.count > 0) {
+        // Claim the image's blocks from the fresh pool in one step
+        Node* nodes = (Node*)mem_alloc_batch(header.count, sizeof(Node));
+        if (nodes == NULL) {
+            pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+            return -1;
+        }
+
+        int valid = check_links(nodes, header.count);
+        if (valid != 0) {
+            pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+            if (valid < 0) printf("Error: %s has a corrupt node link.\n", path);
+            else printf("Error: Memory allocation failed.\n");
+            return -1;
+        }
+        for (size_t i = 0; i < header.count; i++) {
+            uintptr_t offset = (uintptr_t)nodes[i].next;
+            nodes[i].next = offset ? (Node*)((char*)nodes + offset - 1) : NULL;
+        }
+
+        *head = nodes;
+        list_node_count = header.count;
+        put_length(nodes, header.count, 0);
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    return 0;
+}
+
+// Distance, in nodes, of the prefetch ahead of the visit
+#define PREFETCH_AHEAD 4
+
+// Call visit for every element in order under a single read lock. Nodes a
+// few links ahead are prefetched while the current one is visited, so
+// scattered nodes are already on their way from memory when reached.
+// Returns the number of elements visited.
+size_t list_foreach(Node** head, list_visit_fn visit, void* ctx) {
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    size_t visited = 0;
+    Node* ahead = *head;
+    for (int i = 0; i < PREFETCH_AHEAD && ahead != NULL; i++) {
+        __builtin_prefetch(ahead);
+        ahead = ahead->next;
+    }
+
+    for (Node* current = *head; current != NULL; current = current->next) {
+        if (ahead != NULL) {
+            __builtin_prefetch(ahead);
+            ahead = ahead->next;
+        }
+        visited++;
+        if (visit(current->data, ctx)) break;
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    return visited;
+}
+
+// Adapter from mem_foreach_allocated blocks to list_visit_fn elements
+typedef struct {
+    list_visit_fn visit;
+    void* ctx;
+} PoolScanArgs;
+
+static int pool_scan_block(void* block, size_t size, void* ctx) {
+    PoolScanArgs* args = ctx;
+    (void)size;
+    return args->visit(((Node*)block)->data, args->ctx);
+}
+
+// Call visit for every element, in pool address order rather than list
+// order. Walking the pool is sequential, so it suits queries where order
+// does not matter, like counts and statistics. The pool is only scanned
+// when the list owns every node in it and nothing else is allocated there;
+// otherwise the list is walked instead. Returns the number of elements
+// visited.
+size_t list_pool_scan(Node** head, list_visit_fn visit, void* ctx) {
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    size_t count = owns_pool(head) ? list_node_count : 0;
+    size_t visited;
+    if (count > 0 && mem_allocated_blocks(NULL, 0) == count) {
+        PoolScanArgs args = { visit, ctx };
+        visited = mem_foreach_allocated(pool_scan_block, &args);
+    } else {
+        visited = 0;
+        for (Node* current = *head; current != NULL; current = current->next) {
+            visited++;
+            if (visit(current->data, ctx)) break;
+        }
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    return visited;
+}
+
+// Visitor for list_contains: stops at the first match
+static int contains_visit(uint16_t data, void* ctx) {
+    int* args = ctx;
+    if (data == (uint16_t)args[0]) {
+        args[1] = 1;
+        return 1;
+    }
+    return 0;
+}
+
+// Check whether any element equals data, scanning the pool in address order
+// when the list owns it
+int list_contains(Node** head, uint16_t data) {
+    int args[2] = { data, 0 };
+    list_pool_scan(head, contains_visit, args);
+    return args[1];
+}
+
+// Start a batched traversal of the list at head
+void list_cursor_init(ListCursor* cursor, Node** head) {
+    cursor->head = head;
+    cursor->next = NULL;
+    cursor->started = 0;
+}
+
+// Copy up to n of the following elements into out, taking the read lock
+// once for the whole batch. Returns how many were copied; 0 at the end.
+// Between batches the cursor holds a pointer to the next node, so that node
+// must not be deleted while the traversal is in progress.
+size_t list_cursor_next_batch(ListCursor* cursor, uint16_t* out, size_t n) {
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    Node* current = cursor->started ? cursor->next : *cursor->head;
+    cursor->started = 1;
+
+    Node* ahead = current;
+    for (int i = 0; i < PREFETCH_AHEAD && ahead != NULL; i++) {
+        __builtin_prefetch(ahead);
+        ahead = ahead->next;
+    }
+
+    size_t count = 0;
+    while (current != NULL && count < n) {
+        if (ahead != NULL) {
+            __builtin_prefetch(ahead);
+            ahead = ahead->next;
+        }
+        out[count++] = current->data;
         current = current->next;
     }
-    printf("]");
+    cursor->next = current;
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    return count;
+}
+
+// Share of a reduction handled by one thread
+typedef struct {
+    Node** nodes;
+    size_t begin;
+    size_t end;
+    uint16_t low;
+    uint16_t high;
+    ListReduction result;
+} ReduceTask;
+
+// Worker pool for list_parallel_reduce. Threads are started on first use,
+// wait for the next round between reductions and run until
+// list_parallel_shutdown. The calling thread always takes task 0.
+pthread_mutex_t reduce_call_mutex = PTHREAD_MUTEX_INITIALIZER;  // One reduction at a time
+pthread_mutex_t reduce_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t reduce_start = PTHREAD_COND_INITIALIZER;
+pthread_cond_t reduce_done = PTHREAD_COND_INITIALIZER;
+pthread_t reduce_workers[LIST_MAX_WORKERS];
+unsigned reduce_worker_round[LIST_MAX_WORKERS];  // Round each worker last saw
+int reduce_worker_count = 0;
+ReduceTask* reduce_tasks = NULL;
+int reduce_task_count = 0;
+int reduce_pending = 0;
+unsigned reduce_round = 0;
+int reduce_stop = 0;
 
-    pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
+// Aggregate one range of nodes. The nodes are in address order, so the loads
+// walk the pool forwards and the prefetch only has to run a few nodes ahead.
+static void reduce_range(ReduceTask* task) {
+    ListReduction* result = &task->result;
+    memset(result, 0, sizeof(*result));
+    result->min = UINT16_MAX;
+
+    for (size_t i = task->begin; i < task->end; i++) {
+        if (i + PREFETCH_AHEAD < task->end) __builtin_prefetch(task->nodes[i + PREFETCH_AHEAD]);
+
+        uint16_t value = task->nodes[i]->data;
+        result->count++;
+        result->sum += value;
+        if (value < result->min) result->min = value;
+        if (value > result->max) result->max = value;
+        if (value >= task->low && value <= task->high) result->matches++;
+        result->histogram[value >> 8]++;
+    }
+}
+
+static void* reduce_worker(void* arg) {
+    int id = (int)(intptr_t)arg;
+
+    pthread_mutex_lock(&reduce_mutex);
+    unsigned seen = reduce_worker_round[id];
+    for (;;) {
+        while (!reduce_stop && reduce_round == seen) {
+            pthread_cond_wait(&reduce_start, &reduce_mutex);
+        }
+        if (reduce_stop) break;
+        seen = reduce_round;
+
+        // Worker id runs task id + 1 if this round has that many tasks
+        if (id + 1 < reduce_task_count) {
+            ReduceTask* task = &reduce_tasks[id + 1];
+            pthread_mutex_unlock(&reduce_mutex);
+            reduce_range(task);
+            pthread_mutex_lock(&reduce_mutex);
+            if (--reduce_pending == 0) pthread_cond_signal(&reduce_done);
+        }
+    }
+    pthread_mutex_unlock(&reduce_mutex);
+    return NULL;
+}
+
+// Collect the list's nodes for the reduction. When the list owns the pool
+// and the pool holds nothing else, the nodes are taken in address order from
+// the block metadata; otherwise the list is walked. Returns the node count,
+// or -1 on error.
+static long gather_nodes(Node** head, Node*** out) {
+    size_t count = owns_pool(head) ? list_node_count : 0;
+    Node** nodes = malloc((count ? count : 1) * sizeof(Node*));
+    if (nodes == NULL) return -1;
+
+    if (count == 0 || mem_allocated_blocks((void**)nodes, count) != count) {
+        count = 0;
+        for (Node* current = *head; current != NULL; current = current->next) {
+            count++;
+        }
+        Node** grown = realloc(nodes, (count ? count : 1) * sizeof(Node*));
+        if (grown == NULL) {
+            free(nodes);
+            return -1;
+        }
+        nodes = grown;
+
+        size_t i = 0;
+        for (Node* current = *head; current != NULL; current = current->next) {
+            nodes[i++] = current;
+        }
+    }
+
+    *out = nodes;
+    return (long)count;
+}
+
+// Compute count, sum, min, max, a histogram and the number of values in
+// [low, high] with nThreads threads. Order does not matter for any of them,
+// so the nodes are split into contiguous ranges of the pool rather than list
+// segments. The split needs every node first and gather_nodes collects them
+// on the calling thread: a sequential pass over the block metadata when the
+// list owns its pool, otherwise a walk of the list that waits on memory at
+// every node. That serial step bounds the speedup from more threads, most
+// of all for a list that shares its pool. Writers are held off for the
+// duration. Returns 0 on success and -1 on error.
+int list_parallel_reduce(Node** head, int nThreads, uint16_t low, uint16_t high, ListReduction* out) {
+    if (nThreads < 1) nThreads = 1;
+    if (nThreads > LIST_MAX_WORKERS) nThreads = LIST_MAX_WORKERS;
+
+    pthread_mutex_lock(&reduce_call_mutex);
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    Node** nodes;
+    long count = gather_nodes(head, &nodes);
+    if (count < 0) {
+        pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+        pthread_mutex_unlock(&reduce_call_mutex);
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&reduce_mutex);
+    while (reduce_worker_count < nThreads - 1) {
+        int id = reduce_worker_count;
+        reduce_worker_round[id] = reduce_round;
+        if (pthread_create(&reduce_workers[id], NULL, reduce_worker, (void*)(intptr_t)id) != 0) {
+            nThreads = id + 1;  // Make do with the workers we have
+            break;
+        }
+        reduce_worker_count++;
+    }
+
+    ReduceTask tasks[LIST_MAX_WORKERS];
+    for (int t = 0; t < nThreads; t++) {
+        tasks[t].nodes = nodes;
+        tasks[t].begin = (size_t)count * t / nThreads;
+        tasks[t].end = (size_t)count * (t + 1) / nThreads;
+        tasks[t].low = low;
+        tasks[t].high = high;
+    }
+    reduce_tasks = tasks;
+    reduce_task_count = nThreads;
+    reduce_pending = nThreads - 1;
+    reduce_round++;
+    pthread_cond_broadcast(&reduce_start);
+    pthread_mutex_unlock(&reduce_mutex);
+
+    reduce_range(&tasks[0]);
+
+    pthread_mutex_lock(&reduce_mutex);
+    while (reduce_pending > 0) {
+        pthread_cond_wait(&reduce_done, &reduce_mutex);
+    }
+    reduce_tasks = NULL;
+    reduce_task_count = 0;
+    pthread_mutex_unlock(&reduce_mutex);
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    pthread_mutex_unlock(&reduce_call_mutex);
+    free(nodes);
+
+    // Merge the partial results
+    memset(out, 0, sizeof(*out));
+    out->min = UINT16_MAX;
+    for (int t = 0; t < nThreads; t++) {
+        ListReduction* part = &tasks[t].result;
+        out->count += part->count;
+        out->sum += part->sum;
+        out->matches += part->matches;
+        if (part->count > 0 && part->min < out->min) out->min = part->min;
+        if (part->count > 0 && part->max > out->max) out->max = part->max;
+        for (int b = 0; b < LIST_HIST_BINS; b++) {
+            out->histogram[b] += part->histogram[b];
+        }
+    }
+    if (out->count == 0) out->min = 0;
+    return 0;
+}
+
+// Stop the reduction worker threads
+void list_parallel_shutdown() {
+    pthread_mutex_lock(&reduce_call_mutex);
+
+    pthread_mutex_lock(&reduce_mutex);
+    reduce_stop = 1;
+    pthread_cond_broadcast(&reduce_start);
+    pthread_mutex_unlock(&reduce_mutex);
+
+    for (int i = 0; i < reduce_worker_count; i++) {
+        pthread_join(reduce_workers[i], NULL);
+    }
+    reduce_worker_count = 0;
+    reduce_stop = 0;
+
+    pthread_mutex_unlock(&reduce_call_mutex);
+}
+
+// Links that jump at most this far ahead count as in order for list_disorder,
+// since hardware prefetchers follow short forward strides
+#define LIST_NEAR_BYTES 256
+
+// Fraction of links, from 0.0 to 1.0, that point backwards in memory or
+// further ahead than LIST_NEAR_BYTES. A list built by appending to a fresh
+// pool scores 0; after enough inserts and deletes in the middle it tends
+// towards 1, which is the point where list_relayout pays off.
+double list_disorder(Node** head) {
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    size_t links = 0;
+    size_t scattered = 0;
+    for (Node* current = *head; current != NULL && current->next != NULL; current = current->next) {
+        links++;
+        if ((char*)current->next <= (char*)current || (char*)current->next - (char*)current > LIST_NEAR_BYTES) {
+            scattered++;
+        }
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    return links > 0 ? (double)scattered / links : 0.0;
+}
+
+// Order node pointers by address
+static int compare_node_address(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t)*(Node* const*)a;
+    uintptr_t y = (uintptr_t)*(Node* const*)b;
+    return (x > y) - (x < y);
+}
+
+// Rearrange the list so list order matches address order in the pool. The
+// nodes stay where they are and their values move: the first element goes
+// to the lowest addressed node, the second to the next, and so on, so no
+// pool space is needed beyond the list's own blocks. Node pointers held by
+// callers afterwards refer to different elements. Returns 0 on success and
+// -1 on error.
+int list_relayout(Node** head) {
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+    list_version++;
+
+    // Walk the list once into arrays sized by the pool's node count; they
+    // only grow if the count is short, e.g. after list_merge_sorted across pools
+    size_t cap = list_node_count > 16 ? list_node_count : 16;
+    Node** nodes = malloc(cap * sizeof(Node*));
+    uint16_t* values = malloc(cap * sizeof(uint16_t));
+    size_t count = 0;
+    int failed = (nodes == NULL || values == NULL);
+    for (Node* current = *head; current != NULL && !failed; current = current->next) {
+        if (count == cap) {
+            cap *= 2;
+            Node** grownNodes = realloc(nodes, cap * sizeof(Node*));
+            if (grownNodes != NULL) nodes = grownNodes;
+            uint16_t* grownValues = realloc(values, cap * sizeof(uint16_t));
+            if (grownValues != NULL) values = grownValues;
+            failed = (grownNodes == NULL || grownValues == NULL);
+            if (failed) break;
+        }
+        nodes[count] = current;
+        values[count] = current->data;
+        count++;
+    }
+    if (failed) {
+        pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+        printf("Error: Memory allocation failed.\n");
+        free(nodes);
+        free(values);
+        return -1;
+    }
+
+    if (count >= 2) {
+        // When the pool holds only the list's nodes the block metadata
+        // already has them in address order; otherwise sort the pointers
+        if (count == list_node_count && mem_allocated_blocks(NULL, 0) == count) {
+            mem_allocated_blocks((void**)nodes, count);
+        } else {
+            qsort(nodes, count, sizeof(Node*), compare_node_address);
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            nodes[i]->data = values[i];
+            nodes[i]->next = (i + 1 < count) ? nodes[i + 1] : NULL;
+        }
+        move_length(*head, nodes[0], 0);
+        put_length(nodes[0], count, 0);  // The walk counted the list
+        *head = nodes[0];
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    free(nodes);
+    free(values);
+    return 0;
+}
+
+// Count the nodes in the list from the length kept by every insert, delete
+// and merge. A length gone stale after list_insert_after is recounted once
+// under the write lock and kept.
+int list_count_nodes(Node** head) {
+    pthread_rwlock_rdlock(&list_lock);  // Lock for reading
+
+    ListLength* entry = find_length(*head);
+    if (*head == NULL || (entry != NULL && !entry->stale)) {
+        int count = entry != NULL ? (int)entry->count : 0;
+        pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+        return count;
+    }
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+
+    size_t count = 0;
+    for (Node* current = *head; current != NULL; current = current->next) {
+        count++;
+    }
+    put_length(*head, count, 0);
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+    return (int)count;
 }
 
 // Clean up the linked list
 void list_cleanup(Node** head) {
-    pthread_mutex_lock(&list_mutex);  // Lock the mutex
+    pthread_rwlock_wrlock(&list_lock);  // Lock for writing
+    list_version++;
 
+    // Detach the whole chain, then free it without holding the lock
     Node* current = *head;
+    *head = NULL;
+    ListLength entry;
+    if (take_length(current, &entry) && !entry.stale && entry.count <= list_node_count) {
+        list_node_count -= entry.count;
+    } else {
+        for (Node* node = current; node != NULL && list_node_count > 0; node = node->next) {
+            list_node_count--;
+        }
+    }
+
+    pthread_rwlock_unlock(&list_lock);  // Unlock the lock
+
     while (current != NULL) {
         Node* next = current->next;
         mem_free(current);
         current = next;
     }
-    *head = NULL;
-
-    pthread_mutex_unlock(&list_mutex);  // Unlock the mutex
 }
@@ -11,14 +11,54 @@ typedef struct Node {
     struct Node* next;
 } Node;
 
+// Called by list_foreach for every element; return nonzero to stop early
+typedef int (*list_visit_fn)(uint16_t data, void* ctx);
+
+// Position of a batched traversal, see list_cursor_next_batch
+typedef struct {
+    Node** head;
+    Node* next;     // Node the next batch starts at
+    int started;
+} ListCursor;
+
+// Histogram bins of list_parallel_reduce; bin b counts values b * 256 to b * 256 + 255
+#define LIST_HIST_BINS 256
+#define LIST_MAX_WORKERS 16
+
+// Aggregates computed by list_parallel_reduce in one pass
+typedef struct {
+    size_t count;
+    unsigned long long sum;
+    uint16_t min;
+    uint16_t max;
+    size_t matches;                    // Values within [low, high]
+    size_t histogram[LIST_HIST_BINS];
+} ListReduction;
+
 void list_init(Node** head, size_t size);
 void list_insert(Node** head, uint16_t data);
 void list_insert_after(Node* prev_node, uint16_t data);
 void list_insert_before(Node** head, Node* next_node, uint16_t data);
+void list_insert_sorted(Node** head, uint16_t data);
+void list_sort(Node** head);
+void list_merge_sorted(Node** head, Node** other);
 void list_delete(Node** head, uint16_t data);
 Node* list_search(Node** head, uint16_t data);
 void list_display(Node** head);
 void list_display_range(Node** head, Node* start_node, Node* end_node);
+size_t list_to_buffer(Node** head, char* buf, size_t cap);
+int list_write_fd(Node** head, int fd);
+int list_save(Node** head, const char* path);
+int list_load(Node** head, const char* path);
+size_t list_foreach(Node** head, list_visit_fn visit, void* ctx);
+size_t list_pool_scan(Node** head, list_visit_fn visit, void* ctx);
+int list_contains(Node** head, uint16_t data);
+void list_cursor_init(ListCursor* cursor, Node** head);
+size_t list_cursor_next_batch(ListCursor* cursor, uint16_t* out, size_t n);
+int list_parallel_reduce(Node** head, int nThreads, uint16_t low, uint16_t high, ListReduction* out);
+void list_parallel_shutdown();
+double list_disorder(Node** head);
+int list_relayout(Node** head);
 int list_count_nodes(Node** head);
 void list_cleanup(Node** head);
 
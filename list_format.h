@@ -0,0 +1,59 @@
+#ifndef LIST_FORMAT_H
+#define LIST_FORMAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+// Element formatting shared by the list modules, so every list displays as
+// "[a, b, c]" like list_display without going through printf per element
+
+// Longest formatted element: five digits plus ", "
+#define LIST_MAX_ELEMENT_CHARS 7
+
+// Write the decimal digits of value to out and return how many were written
+static inline size_t list_format_u16(char* out, uint16_t value) {
+    char digits[5];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+// Display output collected on the stack and written to stdout as it fills
+typedef struct {
+    char buf[4096];
+    size_t len;
+} ListPrinter;
+
+static inline void list_print_begin(ListPrinter* printer) {
+    printer->buf[0] = '[';
+    printer->len = 1;
+}
+
+// Append one element; the last one gets no separator
+static inline void list_print_element(ListPrinter* printer, uint16_t value, int last) {
+    // Keep room for the element and the closing bracket
+    if (printer->len + LIST_MAX_ELEMENT_CHARS + 1 > sizeof(printer->buf)) {
+        fwrite(printer->buf, 1, printer->len, stdout);
+        printer->len = 0;
+    }
+    printer->len += list_format_u16(printer->buf + printer->len, value);
+    if (!last) {
+        printer->buf[printer->len++] = ',';
+        printer->buf[printer->len++] = ' ';
+    }
+}
+
+static inline void list_print_end(ListPrinter* printer) {
+    printer->buf[printer->len++] = ']';
+    fwrite(printer->buf, 1, printer->len, stdout);
+}
+
+#endif // LIST_FORMAT_H
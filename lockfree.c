@@ -0,0 +1,220 @@
+#include "memory_manager.h"
+#include "epoch.h"
+#include "lockfree.h"
+
+// Nodes popped from the stack or queue go through mem_retire, so a node is
+// not handed out again while another thread may still read it. That also
+// rules out the ABA problem on the compare-and-swap of top and head.
+
+// Initialize a ring buffer holding at least capacity values
+int ring_init(RingBuffer* ring, size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size *= 2;
+
+    ring->cells = (RingCell*)mem_alloc(size * sizeof(RingCell));
+    if (ring->cells == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+    for (size_t i = 0; i < size; i++) {
+        ring->cells[i].seq = i;
+    }
+    ring->mask = size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    return 0;
+}
+
+// Append a value. A cell is free for position pos when its seq equals pos.
+int ring_push(RingBuffer* ring, uint16_t data) {
+    size_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    for (;;) {
+        RingCell* cell = &ring->cells[pos & ring->mask];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->data = data;
+                __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+                return 0;
+            }
+        } else if (diff < 0) {
+            return -1;  // Full
+        } else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Remove the oldest value. A cell holds the value for pos when its seq is pos + 1.
+int ring_pop(RingBuffer* ring, uint16_t* data) {
+    size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    for (;;) {
+        RingCell* cell = &ring->cells[pos & ring->mask];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *data = cell->data;
+                __atomic_store_n(&cell->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+                return 0;
+            }
+        } else if (diff < 0) {
+            return -1;  // Empty
+        } else {
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Release the ring's cells. No other thread may still use the ring.
+void ring_cleanup(RingBuffer* ring) {
+    mem_free(ring->cells);
+    ring->cells = NULL;
+}
+
+// Allocate a node for the stack or queue
+static LfNode* new_node(uint16_t data) {
+    LfNode* node = (LfNode*)mem_alloc(sizeof(LfNode));
+    if (node == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return NULL;
+    }
+    node->data = data;
+    node->next = NULL;
+    return node;
+}
+
+// Initialize an empty stack
+void lfstack_init(LfStack* stack) {
+    stack->top = NULL;
+}
+
+// Push a value on the stack
+int lfstack_push(LfStack* stack, uint16_t data) {
+    LfNode* node = new_node(data);
+    if (node == NULL) return -1;
+
+    node->next = __atomic_load_n(&stack->top, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&stack->top, &node->next, node, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    return 0;
+}
+
+// Pop the most recently pushed value
+int lfstack_pop(LfStack* stack, uint16_t* data) {
+    epoch_enter();
+
+    LfNode* top = __atomic_load_n(&stack->top, __ATOMIC_ACQUIRE);
+    while (top != NULL &&
+           !__atomic_compare_exchange_n(&stack->top, &top, top->next, 1,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+    }
+
+    epoch_exit();
+    if (top == NULL) return -1;
+
+    *data = top->data;
+    mem_retire(top);
+    return 0;
+}
+
+// Free the nodes left on the stack. No other thread may still use the stack.
+void lfstack_cleanup(LfStack* stack) {
+    LfNode* current = stack->top;
+    while (current != NULL) {
+        LfNode* next = current->next;
+        mem_free(current);
+        current = next;
+    }
+    stack->top = NULL;
+    epoch_synchronize();
+}
+
+// Initialize an empty queue with its dummy node
+int lfqueue_init(LfQueue* queue) {
+    LfNode* dummy = new_node(0);
+    if (dummy == NULL) return -1;
+
+    queue->head = dummy;
+    queue->tail = dummy;
+    return 0;
+}
+
+// Append a value at the tail
+int lfqueue_enqueue(LfQueue* queue, uint16_t data) {
+    LfNode* node = new_node(data);
+    if (node == NULL) return -1;
+
+    epoch_enter();
+    for (;;) {
+        LfNode* tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+        LfNode* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if (tail != __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE)) continue;
+
+        if (next != NULL) {
+            // The tail is lagging behind; help move it along
+            __atomic_compare_exchange_n(&queue->tail, &tail, next, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        if (__atomic_compare_exchange_n(&tail->next, &next, node, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            __atomic_compare_exchange_n(&queue->tail, &tail, node, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+    epoch_exit();
+    return 0;
+}
+
+// Remove the value at the head. The node holding it becomes the new dummy.
+int lfqueue_dequeue(LfQueue* queue, uint16_t* data) {
+    epoch_enter();
+    for (;;) {
+        LfNode* head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        LfNode* tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+        LfNode* next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+        if (head != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) continue;
+
+        if (next == NULL) {
+            epoch_exit();
+            return -1;  // Empty
+        }
+
+        if (head == tail) {
+            __atomic_compare_exchange_n(&queue->tail, &tail, next, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        uint16_t value = next->data;
+        if (__atomic_compare_exchange_n(&queue->head, &head, next, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            epoch_exit();
+            *data = value;
+            mem_retire(head);
+            return 0;
+        }
+    }
+}
+
+// Free the dummy and any queued nodes. No other thread may still use the queue.
+void lfqueue_cleanup(LfQueue* queue) {
+    LfNode* current = queue->head;
+    while (current != NULL) {
+        LfNode* next = current->next;
+        mem_free(current);
+        current = next;
+    }
+    queue->head = NULL;
+    queue->tail = NULL;
+    epoch_synchronize();
+}
@@ -0,0 +1,65 @@
+#ifndef LOCKFREE_H
+#define LOCKFREE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+// Concurrent containers for producer/consumer pipelines. Storage comes from
+// the memory pool, which the caller sets up with mem_init first. Functions
+// returning int give 0 on success and -1 when the container is full, empty
+// or out of memory.
+
+#define LF_CACHE_LINE 64
+
+// Slot of the ring buffer. seq tells producers and consumers whose turn it is.
+typedef struct {
+    size_t seq;
+    uint16_t data;
+} RingCell;
+
+// Bounded multi-producer multi-consumer queue over a power of two array
+typedef struct {
+    RingCell* cells;
+    size_t mask;
+    char pad0[LF_CACHE_LINE];
+    size_t head;           // Next slot to pop
+    char pad1[LF_CACHE_LINE - sizeof(size_t)];
+    size_t tail;           // Next slot to push
+    char pad2[LF_CACHE_LINE - sizeof(size_t)];
+} RingBuffer;
+
+int ring_init(RingBuffer* ring, size_t capacity);
+int ring_push(RingBuffer* ring, uint16_t data);
+int ring_pop(RingBuffer* ring, uint16_t* data);
+void ring_cleanup(RingBuffer* ring);
+
+// Node of the lock-free stack and queue
+typedef struct LfNode {
+    struct LfNode* next;
+    uint16_t data;
+} LfNode;
+
+// Treiber stack
+typedef struct {
+    LfNode* top;
+} LfStack;
+
+void lfstack_init(LfStack* stack);
+int lfstack_push(LfStack* stack, uint16_t data);
+int lfstack_pop(LfStack* stack, uint16_t* data);
+void lfstack_cleanup(LfStack* stack);
+
+// Michael-Scott queue. head always points at a dummy node.
+typedef struct {
+    LfNode* head;
+    char pad[LF_CACHE_LINE - sizeof(LfNode*)];
+    LfNode* tail;
+} LfQueue;
+
+int lfqueue_init(LfQueue* queue);
+int lfqueue_enqueue(LfQueue* queue, uint16_t data);
+int lfqueue_dequeue(LfQueue* queue, uint16_t* data);
+void lfqueue_cleanup(LfQueue* queue);
+
+#endif // LOCKFREE_H
@@ -0,0 +1,185 @@
+#include "memory_manager.h"
+#include "lru_cache.h"
+
+// Fibonacci hashing: the top bits of the product pick the bucket
+static size_t bucket_of(LruCache* cache, uint32_t key) {
+    return (uint32_t)(key * 2654435769u) >> cache->bucketShift;
+}
+
+// Initialize the cache and a dedicated pool for its nodes and buckets.
+// Returns 0 on success and -1 on error.
+int lru_init(LruCache* cache, size_t capacity) {
+    if (capacity == 0) {
+        printf("Error: Cache capacity cannot be zero.\n");
+        return -1;
+    }
+
+    // At least two buckets per entry keeps the chains short
+    size_t bucketCount = 2;
+    unsigned bucketShift = 31;
+    while (bucketCount < capacity * 2 && bucketShift > 1) {
+        bucketCount *= 2;
+        bucketShift--;
+    }
+
+    mem_init(capacity * sizeof(LruNode) + bucketCount * sizeof(LruNode*));
+    cache->nodes = (LruNode*)mem_alloc(capacity * sizeof(LruNode));
+    cache->buckets = (LruNode**)mem_alloc(bucketCount * sizeof(LruNode*));
+    if (cache->nodes == NULL || cache->buckets == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+    memset(cache->buckets, 0, bucketCount * sizeof(LruNode*));
+    cache->bucketShift = bucketShift;
+
+    cache->freeList = NULL;
+    for (size_t i = capacity; i > 0; i--) {
+        cache->nodes[i - 1].next = cache->freeList;
+        cache->freeList = &cache->nodes[i - 1];
+    }
+
+    cache->head = NULL;
+    cache->tail = NULL;
+    cache->count = 0;
+    cache->capacity = capacity;
+    memset(&cache->stats, 0, sizeof(cache->stats));
+    pthread_mutex_init(&cache->mutex, NULL);
+    return 0;
+}
+
+// Find the entry for key, or NULL
+static LruNode* find_node(LruCache* cache, uint32_t key) {
+    LruNode* node = cache->buckets[bucket_of(cache, key)];
+    while (node != NULL && node->key != key) {
+        node = node->hashNext;
+    }
+    return node;
+}
+
+// Take node out of its hash chain
+static void unhash_node(LruCache* cache, LruNode* node) {
+    LruNode** link = &cache->buckets[bucket_of(cache, node->key)];
+    while (*link != node) {
+        link = &(*link)->hashNext;
+    }
+    *link = node->hashNext;
+}
+
+// Take node out of the recency list
+static void unlink_node(LruCache* cache, LruNode* node) {
+    if (node->prev != NULL) node->prev->next = node->next; else cache->head = node->next;
+    if (node->next != NULL) node->next->prev = node->prev; else cache->tail = node->prev;
+}
+
+// Make node the most recently used entry
+static void push_front(LruCache* cache, LruNode* node) {
+    node->prev = NULL;
+    node->next = cache->head;
+    if (cache->head != NULL) cache->head->prev = node; else cache->tail = node;
+    cache->head = node;
+}
+
+// Look up key and mark it most recently used. Returns 0 on a hit and -1 on a miss.
+int lru_get(LruCache* cache, uint32_t key, uint32_t* value) {
+    pthread_mutex_lock(&cache->mutex);  // Lock the mutex
+
+    LruNode* node = find_node(cache, key);
+    if (node == NULL) {
+        cache->stats.misses++;
+        pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+        return -1;
+    }
+
+    if (cache->head != node) {
+        unlink_node(cache, node);
+        push_front(cache, node);
+    }
+    *value = node->value;
+    cache->stats.hits++;
+
+    pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+    return 0;
+}
+
+// Insert or update key, evicting the least recently used entry when full
+void lru_put(LruCache* cache, uint32_t key, uint32_t value) {
+    pthread_mutex_lock(&cache->mutex);  // Lock the mutex
+
+    LruNode* node = find_node(cache, key);
+    if (node != NULL) {
+        unlink_node(cache, node);
+    } else {
+        if (cache->freeList != NULL) {
+            node = cache->freeList;
+            cache->freeList = node->next;
+            cache->count++;
+        } else {
+            // Reuse the evicted node for the new entry
+            node = cache->tail;
+            unlink_node(cache, node);
+            unhash_node(cache, node);
+            cache->stats.evictions++;
+        }
+
+        node->key = key;
+        size_t bucket = bucket_of(cache, key);
+        node->hashNext = cache->buckets[bucket];
+        cache->buckets[bucket] = node;
+    }
+    node->value = value;
+    push_front(cache, node);
+
+    pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+}
+
+// Drop key from the cache. Returns 0 if it was present and -1 otherwise.
+int lru_remove(LruCache* cache, uint32_t key) {
+    pthread_mutex_lock(&cache->mutex);  // Lock the mutex
+
+    LruNode* node = find_node(cache, key);
+    if (node == NULL) {
+        pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+        return -1;
+    }
+
+    unlink_node(cache, node);
+    unhash_node(cache, node);
+    node->next = cache->freeList;
+    cache->freeList = node;
+    cache->count--;
+
+    pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+    return 0;
+}
+
+// Number of entries in the cache
+size_t lru_count(LruCache* cache) {
+    pthread_mutex_lock(&cache->mutex);  // Lock the mutex
+    size_t count = cache->count;
+    pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+    return count;
+}
+
+// Copy the hit, miss and eviction counters
+void lru_stats(LruCache* cache, LruStats* stats) {
+    pthread_mutex_lock(&cache->mutex);  // Lock the mutex
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+}
+
+// Clean up the cache
+void lru_cleanup(LruCache* cache) {
+    pthread_mutex_lock(&cache->mutex);  // Lock the mutex
+
+    mem_free(cache->buckets);
+    mem_free(cache->nodes);
+    cache->buckets = NULL;
+    cache->nodes = NULL;
+    cache->freeList = NULL;
+    cache->head = NULL;
+    cache->tail = NULL;
+    cache->count = 0;
+
+    pthread_mutex_unlock(&cache->mutex);  // Unlock the mutex
+    pthread_mutex_destroy(&cache->mutex);
+}
@@ -0,0 +1,49 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Entry of the cache, linked into a hash chain and into the recency list
+typedef struct LruNode {
+    uint32_t key;
+    uint32_t value;
+    struct LruNode* prev;      // Recency list, towards the most recently used
+    struct LruNode* next;      // Recency list, towards the least recently used
+    struct LruNode* hashNext;  // Next entry in the same bucket
+} LruNode;
+
+// Counters reported by lru_stats
+typedef struct {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+} LruStats;
+
+// Fixed capacity key/value cache that evicts the least recently used entry.
+// All nodes are carved from the pool up front, so get, put and evict never
+// call into the allocator.
+typedef struct {
+    LruNode** buckets;
+    unsigned bucketShift;      // 32 minus log2 of the bucket count
+    LruNode* nodes;            // Block holding every node
+    LruNode* freeList;         // Unused nodes, chained through next
+    LruNode* head;             // Most recently used
+    LruNode* tail;             // Least recently used, evicted first
+    size_t count;
+    size_t capacity;
+    LruStats stats;
+    pthread_mutex_t mutex;
+} LruCache;
+
+int lru_init(LruCache* cache, size_t capacity);
+int lru_get(LruCache* cache, uint32_t key, uint32_t* value);
+void lru_put(LruCache* cache, uint32_t key, uint32_t value);
+int lru_remove(LruCache* cache, uint32_t key);
+size_t lru_count(LruCache* cache);
+void lru_stats(LruCache* cache, LruStats* stats);
+void lru_cleanup(LruCache* cache);
+
+#endif // LRU_CACHE_H
@@ -0,0 +1,178 @@
+#include "memory_manager.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "gitdata.h"
+
+// Offline analyzer for heap maps written by mem_dump_map. Reads a file of
+// CSV or binary snapshots, prints how free space and fragmentation changed
+// from one snapshot to the next, and the distribution of free block sizes
+// in the last snapshot.
+
+#define SIZE_CLASSES 64   // Power of two classes of free block sizes
+
+// Summary of one snapshot
+typedef struct {
+    uint64_t timestamp_ns;
+    uint64_t pool_size;
+    uint64_t used_bytes;
+    uint64_t used_blocks;
+    uint64_t free_bytes;
+    uint64_t free_blocks;
+    uint64_t largest_free;
+    uint64_t class_blocks[SIZE_CLASSES];   // Free blocks of size [2^k, 2^(k+1))
+    uint64_t class_bytes[SIZE_CLASSES];
+} Snapshot;
+
+// Snapshots read so far
+Snapshot* snapshots = NULL;
+size_t snapshotCount = 0;
+size_t snapshotCapacity = 0;
+
+// Start a new snapshot and return it
+static Snapshot* add_snapshot(uint64_t timestamp_ns, uint64_t pool_size) {
+    if (snapshotCount == snapshotCapacity) {
+        snapshotCapacity = snapshotCapacity ? snapshotCapacity * 2 : 16;
+        snapshots = realloc(snapshots, snapshotCapacity * sizeof(Snapshot));
+        if (snapshots == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+    Snapshot* snapshot = &snapshots[snapshotCount++];
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->timestamp_ns = timestamp_ns;
+    snapshot->pool_size = pool_size;
+    return snapshot;
+}
+
+// Account one block in a snapshot
+static void add_block(Snapshot* snapshot, uint64_t size, int state) {
+    if (state != MEM_MAP_FREE) {
+        snapshot->used_bytes += size;
+        snapshot->used_blocks++;
+        return;
+    }
+
+    snapshot->free_bytes += size;
+    snapshot->free_blocks++;
+    if (size > snapshot->largest_free) snapshot->largest_free = size;
+
+    int k = size > 0 ? 63 - __builtin_clzll(size) : 0;
+    snapshot->class_blocks[k]++;
+    snapshot->class_bytes[k] += size;
+}
+
+// Parse binary snapshots. Returns 0 on success and -1 on a malformed file.
+static int read_binary(const char* data, size_t len) {
+    size_t pos = 0;
+    while (pos < len) {
+        MemMapHeader header;
+        if (len - pos < sizeof(header)) return -1;
+        memcpy(&header, data + pos, sizeof(header));
+        pos += sizeof(header);
+        if (header.magic != MEM_MAP_MAGIC || header.version != MEM_MAP_VERSION ||
+            header.block_count > (len - pos) / sizeof(uint64_t)) return -1;
+
+        Snapshot* snapshot = add_snapshot(header.timestamp_ns, header.pool_size);
+        for (uint64_t i = 0; i < header.block_count; i++) {
+            uint64_t record;
+            memcpy(&record, data + pos, sizeof(record));
+            pos += sizeof(record);
+            add_block(snapshot, record >> 2, (int)(record & 3));
+        }
+    }
+    return 0;
+}
+
+// Parse CSV snapshots. Returns 0 on success and -1 on a malformed file.
+static int read_csv(char* data) {
+    Snapshot* snapshot = NULL;
+    for (char* line = strtok(data, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        unsigned long long timestamp, poolSize, offset, size;
+        char state[16];
+        if (sscanf(line, "# mem_map timestamp_ns=%llu pool_size=%llu", &timestamp, &poolSize) == 2) {
+            snapshot = add_snapshot(timestamp, poolSize);
+        } else if (sscanf(line, "%llu,%llu,%15s", &offset, &size, state) == 3) {
+            if (snapshot == NULL) return -1;
+            add_block(snapshot, size, strcmp(state, "free") == 0 ? MEM_MAP_FREE : MEM_MAP_USED);
+        } else if (strcmp(line, "offset,size,state") != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Share of free space outside the largest free block: 0 when all free space
+// is in one block, approaching 1 as it splinters
+static double fragmentation(const Snapshot* snapshot) {
+    if (snapshot->free_bytes == 0) return 0.0;
+    return 1.0 - (double)snapshot->largest_free / snapshot->free_bytes;
+}
+
+static void print_report() {
+    printf("%8s %10s %12s %12s %12s %11s %12s %13s\n", "snapshot", "time_s", "pool_size",
+           "used_bytes", "free_bytes", "free_blocks", "largest_free", "fragmentation");
+
+    size_t worst = 0;
+    for (size_t i = 0; i < snapshotCount; i++) {
+        const Snapshot* snapshot = &snapshots[i];
+        double elapsed = (double)(snapshot->timestamp_ns - snapshots[0].timestamp_ns) / 1e9;
+        printf("%8zu %10.3f %12llu %12llu %12llu %11llu %12llu %13.3f\n", i, elapsed,
+               (unsigned long long)snapshot->pool_size, (unsigned long long)snapshot->used_bytes,
+               (unsigned long long)snapshot->free_bytes, (unsigned long long)snapshot->free_blocks,
+               (unsigned long long)snapshot->largest_free, fragmentation(snapshot));
+        if (fragmentation(snapshot) > fragmentation(&snapshots[worst])) worst = i;
+    }
+    printf("\nPeak fragmentation %.3f in snapshot %zu\n", fragmentation(&snapshots[worst]), worst);
+
+    const Snapshot* last = &snapshots[snapshotCount - 1];
+    printf("\nFree block sizes in snapshot %zu:\n", snapshotCount - 1);
+    printf("%24s %12s %12s\n", "size", "blocks", "bytes");
+    for (int k = 0; k < SIZE_CLASSES; k++) {
+        if (last->class_blocks[k] == 0) continue;
+        char range[48];
+        snprintf(range, sizeof(range), "[%llu, %llu)", 1ull << k, k < 63 ? 1ull << (k + 1) : 0ull);
+        printf("%24s %12llu %12llu\n", range, (unsigned long long)last->class_blocks[k],
+               (unsigned long long)last->class_bytes[k]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2) {
+        printf("Usage: %s <heap map file>\n", argv[0]);
+        printf("Reads snapshots written by mem_dump_map in CSV or binary format.\n");
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        printf("Error: Failed to open %s for reading.\n", argv[1]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = malloc(len + 1);
+    if (data == NULL || fread(data, 1, len, file) != (size_t)len) {
+        printf("Error: Failed to read %s.\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+    data[len] = '\0';
+
+    uint32_t magic = 0;
+    if (len >= (long)sizeof(magic)) memcpy(&magic, data, sizeof(magic));
+    int failed = magic == MEM_MAP_MAGIC ? read_binary(data, len) : read_csv(data);
+    free(data);
+    if (failed || snapshotCount == 0) {
+        printf("Error: %s is not a heap map.\n", argv[1]);
+        return 1;
+    }
+
+    print_report();
+    free(snapshots);
+    return 0;
+}
@@ -0,0 +1,341 @@
+#include "memory_manager.h"
+#include "mem_profile.h"
+#include <stdint.h>
+#include <execinfo.h>
+
+#define PROFILE_SKIP_FRAMES 2      // mem_profile_note_alloc and mem_alloc
+#define INITIAL_LIVE_CAPACITY 1024 // Initial size of the sampled block table
+
+// A sampled block that has not been freed yet
+typedef struct {
+    void* block;      // NULL for an empty slot
+    int site;         // Index into profileSites
+    size_t weight;    // Bytes this sample stands for
+} LiveSample;
+
+// Global variables for profiling. profileMutex guards the tables; the sample
+// rate is read without it on every allocation.
+size_t memProfileSampleBytes = 0;
+unsigned long profileGeneration = 0;    // Bumped by mem_profile_start
+pthread_mutex_t profileMutex = PTHREAD_MUTEX_INITIALIZER;
+MemProfileSite profileSites[MEM_PROFILE_MAX_SITES];
+size_t profileSiteCount = 0;
+LiveSample* liveSamples = NULL;         // Open addressing table keyed by block
+size_t liveCapacity = 0;
+size_t liveCount = 0;
+
+// Per thread sampling state
+static __thread long myCountdown = 0;               // Bytes left until the next sample
+static __thread unsigned long myGeneration = 0;
+static __thread uint64_t myRandom = 0;
+
+// Next sampling interval, drawn uniformly from [1, 2 * sample_bytes] so the
+// mean is sample_bytes and allocations with a fixed stride are not aliased
+static long next_interval(size_t sampleBytes) {
+    if (myRandom == 0) myRandom = (uint64_t)(uintptr_t)&myRandom | 1;
+    myRandom ^= myRandom << 13;
+    myRandom ^= myRandom >> 7;
+    myRandom ^= myRandom << 17;
+    return (long)(myRandom % (2 * sampleBytes)) + 1;
+}
+
+static size_t hash_ptr(void* ptr, size_t capacity) {
+    return (size_t)(((uintptr_t)ptr >> 3) * 0x9E3779B97F4A7C15ull) & (capacity - 1);
+}
+
+// Slot of block in the live table, or of the empty slot where it would go
+static size_t find_live(void* block) {
+    size_t i = hash_ptr(block, liveCapacity);
+    while (liveSamples[i].block != NULL && liveSamples[i].block != block) {
+        i = (i + 1) & (liveCapacity - 1);
+    }
+    return i;
+}
+
+// Double the live table once it is half full. Returns 0 when out of memory.
+static int grow_live() {
+    if (liveCount * 2 < liveCapacity) return 1;
+
+    size_t oldCapacity = liveCapacity;
+    LiveSample* old = liveSamples;
+    size_t newCapacity = oldCapacity ? oldCapacity * 2 : INITIAL_LIVE_CAPACITY;
+    LiveSample* grown = calloc(newCapacity, sizeof(LiveSample));
+    if (grown == NULL) return 0;
+
+    liveSamples = grown;
+    liveCapacity = newCapacity;
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].block != NULL) liveSamples[find_live(old[i].block)] = old[i];
+    }
+    free(old);
+    return 1;
+}
+
+// Empty slot i, shifting later entries of the same probe run back
+static void remove_live(size_t i) {
+    size_t hole = i;
+    for (size_t j = (i + 1) & (liveCapacity - 1); liveSamples[j].block != NULL; j = (j + 1) & (liveCapacity - 1)) {
+        size_t home = hash_ptr(liveSamples[j].block, liveCapacity);
+        // Move j into the hole unless its home lies cyclically in (hole, j]
+        int stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!stays) {
+            liveSamples[hole] = liveSamples[j];
+            hole = j;
+        }
+    }
+    liveSamples[hole].block = NULL;
+    liveCount--;
+}
+
+// Index of the site for a call stack, adding it if needed; -1 when full
+static int find_site(void** frames, int depth) {
+    uint64_t hash = 0;
+    for (int k = 0; k < depth; k++) {
+        hash = (hash ^ (uintptr_t)frames[k]) * 0x100000001B3ull;
+    }
+
+    size_t i = hash & (MEM_PROFILE_MAX_SITES - 1);
+    for (size_t probes = 0; probes < MEM_PROFILE_MAX_SITES; probes++) {
+        MemProfileSite* site = &profileSites[i];
+        if (site->depth == 0) {
+            memcpy(site->frames, frames, depth * sizeof(void*));
+            site->depth = depth;
+            profileSiteCount++;
+            return (int)i;
+        }
+        if (site->depth == depth && memcmp(site->frames, frames, depth * sizeof(void*)) == 0) {
+            return (int)i;
+        }
+        i = (i + 1) & (MEM_PROFILE_MAX_SITES - 1);
+    }
+    return -1;
+}
+
+// Start sampling about one allocation per sample_bytes bytes, dropping the
+// results of any earlier run. A sample_bytes of 1 records every allocation.
+// Returns 0 on success and -1 on error.
+int mem_profile_start(size_t sample_bytes) {
+    if (sample_bytes == 0) {
+        printf("Error: Sampling interval cannot be zero.\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&profileMutex);  // Lock the mutex
+
+    memset(profileSites, 0, sizeof(profileSites));
+    profileSiteCount = 0;
+    if (liveSamples != NULL) memset(liveSamples, 0, liveCapacity * sizeof(LiveSample));
+    liveCount = 0;
+    profileGeneration++;
+    __atomic_store_n(&memProfileSampleBytes, sample_bytes, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&profileMutex);  // Unlock the mutex
+    return 0;
+}
+
+// Stop sampling and release the tables
+void mem_profile_stop() {
+    pthread_mutex_lock(&profileMutex);  // Lock the mutex
+
+    __atomic_store_n(&memProfileSampleBytes, 0, __ATOMIC_RELEASE);
+    memset(profileSites, 0, sizeof(profileSites));
+    profileSiteCount = 0;
+    free(liveSamples);
+    liveSamples = NULL;
+    liveCapacity = 0;
+    liveCount = 0;
+
+    pthread_mutex_unlock(&profileMutex);  // Unlock the mutex
+}
+
+// Count size bytes against the calling thread's countdown and record the
+// call stack when a sample is due. Kept out of line so the frames to skip
+// are always this function and mem_alloc.
+__attribute__((noinline)) void mem_profile_note_alloc(void* block, size_t size) {
+    size_t sampleBytes = __atomic_load_n(&memProfileSampleBytes, __ATOMIC_ACQUIRE);
+    if (sampleBytes == 0 || block == NULL) return;
+
+    unsigned long generation = __atomic_load_n(&profileGeneration, __ATOMIC_RELAXED);
+    if (myGeneration != generation) {
+        myGeneration = generation;
+        myCountdown = next_interval(sampleBytes);
+    }
+    myCountdown -= (long)(size ? size : 1);
+    if (myCountdown > 0) return;
+    myCountdown = next_interval(sampleBytes);
+
+    // A sample stands for the sample_bytes allocated since the previous one
+    size_t weight = size > sampleBytes ? size : sampleBytes;
+
+    void* frames[PROFILE_SKIP_FRAMES + MEM_PROFILE_DEPTH];
+    int depth = backtrace(frames, PROFILE_SKIP_FRAMES + MEM_PROFILE_DEPTH) - PROFILE_SKIP_FRAMES;
+    if (depth < 1) return;
+
+    pthread_mutex_lock(&profileMutex);  // Lock the mutex
+
+    if (__atomic_load_n(&memProfileSampleBytes, __ATOMIC_RELAXED) != 0) {
+        int site = find_site(frames + PROFILE_SKIP_FRAMES, depth);
+        if (site >= 0 && grow_live()) {
+            profileSites[site].total_bytes += weight;
+            profileSites[site].total_count++;
+            profileSites[site].live_bytes += weight;
+            profileSites[site].live_count++;
+
+            LiveSample* slot = &liveSamples[find_live(block)];
+            if (slot->block == block) {
+                // A stale entry for the same address; it was freed unseen
+                profileSites[slot->site].live_bytes -= slot->weight;
+                profileSites[slot->site].live_count--;
+                liveCount--;
+            }
+            slot->block = block;
+            slot->site = site;
+            slot->weight = weight;
+            liveCount++;
+        }
+    }
+
+    pthread_mutex_unlock(&profileMutex);  // Unlock the mutex
+}
+
+// Take block out of the live table if it was sampled. Returns 1 and its site
+// and weight if it was.
+int mem_profile_take(void* block, int* site, size_t* weight) {
+    if (__atomic_load_n(&liveCount, __ATOMIC_RELAXED) == 0) return 0;
+
+    pthread_mutex_lock(&profileMutex);  // Lock the mutex
+
+    int found = 0;
+    if (liveCount > 0) {
+        size_t i = find_live(block);
+        if (liveSamples[i].block != NULL) {
+            *site = liveSamples[i].site;
+            *weight = liveSamples[i].weight;
+            profileSites[*site].live_bytes -= *weight;
+            profileSites[*site].live_count--;
+            remove_live(i);
+            found = 1;
+        }
+    }
+
+    pthread_mutex_unlock(&profileMutex);  // Unlock the mutex
+    return found;
+}
+
+// Put a sample back under a new address, after mem_resize moved its block
+void mem_profile_put(void* block, int site, size_t weight) {
+    pthread_mutex_lock(&profileMutex);  // Lock the mutex
+
+    if (__atomic_load_n(&memProfileSampleBytes, __ATOMIC_RELAXED) != 0 && grow_live()) {
+        profileSites[site].live_bytes += weight;
+        profileSites[site].live_count++;
+
+        LiveSample* slot = &liveSamples[find_live(block)];
+        if (slot->block == block) {
+            // The move itself was sampled as a new allocation; keep the original site
+            profileSites[slot->site].live_bytes -= slot->weight;
+            profileSites[slot->site].live_count--;
+            liveCount--;
+        }
+        slot->block = block;
+        slot->site = site;
+        slot->weight = weight;
+        liveCount++;
+    }
+
+    pthread_mutex_unlock(&profileMutex);  // Unlock the mutex
+}
+
+// Drop block from the live table if it was sampled
+void mem_profile_note_free(void* block) {
+    int site;
+    size_t weight;
+    mem_profile_take(block, &site, &weight);
+}
+
+// The pool was reset, so no sampled block is live any more
+void mem_profile_forget_live() {
+    pthread_mutex_lock(&profileMutex);  // Lock the mutex
+
+    if (liveSamples != NULL) memset(liveSamples, 0, liveCapacity * sizeof(LiveSample));
+    liveCount = 0;
+    for (size_t i = 0; i < MEM_PROFILE_MAX_SITES; i++) {
+        profileSites[i].live_bytes = 0;
+        profileSites[i].live_count = 0;
+    }
+
+    pthread_mutex_unlock(&profileMutex);  // Unlock the mutex
+}
+
+// Order sites by their frames, so dumps taken at different times line up
+static int compare_sites(const void* a, const void* b) {
+    const MemProfileSite* x = a;
+    const MemProfileSite* y = b;
+    for (int k = 0; k < MEM_PROFILE_DEPTH; k++) {
+        uintptr_t fx = k < x->depth ? (uintptr_t)x->frames[k] : 0;
+        uintptr_t fy = k < y->depth ? (uintptr_t)y->frames[k] : 0;
+        if (fx != fy) return (fx > fy) - (fx < fy);
+    }
+    return 0;
+}
+
+// Copy up to cap call sites into out, ordered by their frames. Returns the
+// number of sites recorded, which may exceed cap.
+size_t mem_profile_sites(MemProfileSite* out, size_t cap) {
+    pthread_mutex_lock(&profileMutex);  // Lock the mutex
+
+    size_t n = 0;
+    for (size_t i = 0; i < MEM_PROFILE_MAX_SITES; i++) {
+        if (profileSites[i].depth == 0) continue;
+        if (n < cap) out[n] = profileSites[i];
+        n++;
+    }
+
+    pthread_mutex_unlock(&profileMutex);  // Unlock the mutex
+
+    qsort(out, n < cap ? n : cap, sizeof(MemProfileSite), compare_sites);
+    return n;
+}
+
+// Write one line per call site to fd:
+//
+//   live_bytes live_count total_bytes total_count frame;frame;...
+//
+// preceded by a '#' comment line with the sampling interval. Lines are in
+// the same order in every dump of a process, so dumps can be diffed.
+// Frames are symbolized when the binary exports its symbols (-rdynamic),
+// otherwise addr2line resolves them. Returns 0 on success and -1 on error.
+int mem_profile_dump(int fd) {
+    MemProfileSite* sites = malloc(MEM_PROFILE_MAX_SITES * sizeof(MemProfileSite));
+    if (sites == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+    size_t n = mem_profile_sites(sites, MEM_PROFILE_MAX_SITES);
+
+    int failed = dprintf(fd, "# mem_profile sample_bytes=%zu sites=%zu\n",
+                         __atomic_load_n(&memProfileSampleBytes, __ATOMIC_RELAXED), n) < 0;
+    for (size_t i = 0; i < n && !failed; i++) {
+        MemProfileSite* site = &sites[i];
+        failed = dprintf(fd, "%zu %zu %zu %zu ", site->live_bytes, site->live_count,
+                         site->total_bytes, site->total_count) < 0;
+
+        char** symbols = backtrace_symbols(site->frames, site->depth);
+        for (int k = 0; k < site->depth && !failed; k++) {
+            const char* separator = (k + 1 < site->depth) ? ";" : "\n";
+            if (symbols != NULL) {
+                failed = dprintf(fd, "%s%s", symbols[k], separator) < 0;
+            } else {
+                failed = dprintf(fd, "%p%s", site->frames[k], separator) < 0;
+            }
+        }
+        free(symbols);
+    }
+
+    free(sites);
+    if (failed) {
+        printf("Error: Failed to write the heap profile.\n");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef MEM_PROFILE_H
+#define MEM_PROFILE_H
+
+#include <stddef.h>
+
+// Sampling heap profiler for the memory pool.
+//
+// Between mem_profile_start and mem_profile_stop, mem_alloc samples about
+// one allocation per sample_bytes bytes allocated and records the call stack
+// it came from. Sampled blocks are tracked until they are freed, so every
+// call site reports an estimate of the bytes it currently holds. Diffing two
+// dumps taken some time apart shows which sites leak or allocate the most.
+// While profiling is off mem_alloc and mem_free only test a flag.
+
+#define MEM_PROFILE_DEPTH 4        // Return addresses kept per call site
+#define MEM_PROFILE_MAX_SITES 1024 // Distinct call sites tracked at once
+
+// Allocations attributed to one call stack
+typedef struct {
+    void* frames[MEM_PROFILE_DEPTH];   // Return addresses, innermost first
+    int depth;
+    size_t live_bytes;    // Estimated bytes allocated here and not yet freed
+    size_t live_count;    // Sampled allocations not yet freed
+    size_t total_bytes;   // Estimated bytes allocated here since mem_profile_start
+    size_t total_count;   // Sampled allocations since mem_profile_start
+} MemProfileSite;
+
+int mem_profile_start(size_t sample_bytes);
+void mem_profile_stop();
+size_t mem_profile_sites(MemProfileSite* out, size_t cap);
+int mem_profile_dump(int fd);
+
+// Hooks called by memory_manager.c
+extern size_t memProfileSampleBytes;
+#define MEM_PROFILE_ACTIVE() __builtin_expect(__atomic_load_n(&memProfileSampleBytes, __ATOMIC_RELAXED) != 0, 0)
+void mem_profile_note_alloc(void* block, size_t size);
+void mem_profile_note_free(void* block);
+int mem_profile_take(void* block, int* site, size_t* weight);
+void mem_profile_put(void* block, int site, size_t weight);
+void mem_profile_forget_live();
+
+#endif // MEM_PROFILE_H
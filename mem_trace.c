@@ -0,0 +1,161 @@
+#include "memory_manager.h"
+#include "mem_trace.h"
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Records of one thread waiting to be written
+typedef struct {
+    MemTraceRecord records[MEM_TRACE_BUFFER];
+    size_t count;
+    uint16_t thread;
+} TraceBuffer;
+
+// Global variables for tracing. traceMutex guards the file and the list of
+// buffers; each buffer is only filled by its own thread.
+int memTraceActive = 0;
+uint64_t traceSequence = 0;
+uint64_t traceStartNs = 0;       // CLOCK_MONOTONIC at mem_trace_start
+int traceFd = -1;
+pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+TraceBuffer* traceBuffers[MEM_TRACE_MAX_THREADS];
+uint16_t traceThreadCount = 0;
+pthread_key_t traceKey;
+pthread_once_t traceKeyOnce = PTHREAD_ONCE_INIT;
+
+static __thread TraceBuffer* myBuffer = NULL;
+
+static uint64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Write the buffered records while holding traceMutex
+static void flush_buffer(TraceBuffer* buffer) {
+    const char* p = (const char*)buffer->records;
+    size_t len = buffer->count * sizeof(MemTraceRecord);
+    while (len > 0 && traceFd >= 0) {
+        ssize_t n = write(traceFd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            printf("Error: Failed to write the allocation trace.\n");
+            break;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    buffer->count = 0;
+}
+
+// Flush and drop the buffer of a thread that exits
+static void release_buffer(void* arg) {
+    TraceBuffer* buffer = arg;
+
+    pthread_mutex_lock(&traceMutex);  // Lock the mutex
+    flush_buffer(buffer);
+    for (size_t i = 0; i < MEM_TRACE_MAX_THREADS; i++) {
+        if (traceBuffers[i] == buffer) traceBuffers[i] = NULL;
+    }
+    pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+
+    free(buffer);
+}
+
+static void create_key() {
+    pthread_key_create(&traceKey, release_buffer);
+}
+
+// Buffer of the calling thread, registered on first use
+static TraceBuffer* thread_buffer() {
+    if (myBuffer != NULL) return myBuffer;
+
+    pthread_once(&traceKeyOnce, create_key);
+    TraceBuffer* buffer = calloc(1, sizeof(TraceBuffer));
+    if (buffer == NULL) return NULL;
+
+    pthread_mutex_lock(&traceMutex);  // Lock the mutex
+    size_t slot = 0;
+    while (slot < MEM_TRACE_MAX_THREADS && traceBuffers[slot] != NULL) slot++;
+    if (slot == MEM_TRACE_MAX_THREADS) {
+        pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+        printf("Error: More than %d threads traced at once.\n", MEM_TRACE_MAX_THREADS);
+        free(buffer);
+        return NULL;
+    }
+    traceBuffers[slot] = buffer;
+    buffer->thread = traceThreadCount++;
+    pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+
+    pthread_setspecific(traceKey, buffer);
+    myBuffer = buffer;
+    return buffer;
+}
+
+// Start tracing to fd, which should be empty or at the end of a file.
+// Returns 0 on success and -1 on error.
+int mem_trace_start(int fd) {
+    pthread_mutex_lock(&traceMutex);  // Lock the mutex
+
+    if (traceFd >= 0) {
+        pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+        printf("Error: A trace is already being recorded.\n");
+        return -1;
+    }
+
+    MemTraceHeader header = { MEM_TRACE_MAGIC, MEM_TRACE_VERSION, now_ns(CLOCK_REALTIME) };
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+        printf("Error: Failed to write the allocation trace.\n");
+        return -1;
+    }
+
+    traceFd = fd;
+    traceStartNs = now_ns(CLOCK_MONOTONIC);
+    __atomic_store_n(&memTraceActive, 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+    return 0;
+}
+
+// Stop tracing and write out every thread's buffered records. Other threads
+// must not call into the memory manager meanwhile. fd stays open.
+void mem_trace_stop() {
+    pthread_mutex_lock(&traceMutex);  // Lock the mutex
+
+    __atomic_store_n(&memTraceActive, 0, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < MEM_TRACE_MAX_THREADS; i++) {
+        if (traceBuffers[i] != NULL) flush_buffer(traceBuffers[i]);
+    }
+    traceFd = -1;
+
+    pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+}
+
+// Number the next call. Called inside the pool's critical section, so the
+// numbers follow the order in which calls took effect.
+uint64_t mem_trace_sequence() {
+    return __atomic_add_fetch(&traceSequence, 1, __ATOMIC_RELAXED);
+}
+
+// Append a record to the calling thread's buffer
+void mem_trace_record(int op, uint64_t sequence, uint64_t block, uint64_t result, size_t size) {
+    TraceBuffer* buffer = thread_buffer();
+    if (buffer == NULL) return;
+
+    MemTraceRecord* record = &buffer->records[buffer->count++];
+    record->timestamp_ns = now_ns(CLOCK_MONOTONIC) - traceStartNs;
+    record->sequence = sequence;
+    record->block = block;
+    record->result = result;
+    record->size = size;
+    record->thread = buffer->thread;
+    record->op = (uint8_t)op;
+    memset(record->reserved, 0, sizeof(record->reserved));
+
+    if (buffer->count == MEM_TRACE_BUFFER) {
+        pthread_mutex_lock(&traceMutex);  // Lock the mutex
+        flush_buffer(buffer);
+        pthread_mutex_unlock(&traceMutex);  // Unlock the mutex
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef MEM_TRACE_H
+#define MEM_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary trace of memory manager calls, for replaying real traffic against
+// allocator changes with mem_trace_replay.
+//
+// Between mem_trace_start and mem_trace_stop every mem_init, mem_alloc,
+// mem_alloc_batch, mem_free, mem_free_batch and mem_resize appends a fixed
+// size record to a buffer of the calling thread, which is written out in
+// chunks. Blocks are identified by their offset in the pool, which is
+// unique while they are allocated. Each record carries a sequence number
+// taken inside the pool's critical section, so sorting by it gives the
+// order in which the calls took effect across all threads.
+//
+// Handles and mem_compact are not traced.
+
+#define MEM_TRACE_MAGIC 0x4352544dU   // "MTRC"
+#define MEM_TRACE_VERSION 2
+#define MEM_TRACE_BUFFER 256          // Records buffered per thread
+#define MEM_TRACE_MAX_THREADS 256     // Threads that can trace at once
+#define MEM_TRACE_NONE UINT64_MAX     // Offset of a failed allocation
+
+// Operations in a trace
+enum {
+    MEM_TRACE_INIT = 1,    // size is the pool size
+    MEM_TRACE_ALLOC,       // block is the new block
+    MEM_TRACE_BATCH,       // block is the first block, result the count
+    MEM_TRACE_FREE,        // block is the freed block
+    MEM_TRACE_RESIZE       // block is the old block, result the new one
+};
+
+// Start of a trace file
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t start_ns;   // CLOCK_REALTIME at mem_trace_start
+} MemTraceHeader;
+
+// One traced call
+typedef struct {
+    uint64_t timestamp_ns;   // Since mem_trace_start
+    uint64_t sequence;       // Order of the call across all threads
+    uint64_t block;          // Offset in the pool
+    uint64_t result;         // Depends on op, see above
+    uint64_t size;           // Size asked for, kept whole for any size_t
+    uint16_t thread;         // Small id of the calling thread
+    uint8_t op;
+    uint8_t reserved[5];
+} MemTraceRecord;
+
+int mem_trace_start(int fd);
+void mem_trace_stop();
+
+// Hooks called by memory_manager.c
+extern int memTraceActive;
+#define MEM_TRACE_ACTIVE() __builtin_expect(__atomic_load_n(&memTraceActive, __ATOMIC_RELAXED) != 0, 0)
+uint64_t mem_trace_sequence();
+void mem_trace_record(int op, uint64_t sequence, uint64_t block, uint64_t result, size_t size);
+
+#endif // MEM_TRACE_H
@@ -0,0 +1,294 @@
+#include "memory_manager.h"
+#include "mem_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gitdata.h"
+
+// Replays a trace written by mem_trace_start against the memory manager
+// this program is linked with, so allocator changes can be compared on real
+// traffic. Calls are replayed on one thread in the order they took effect.
+// Reports throughput, latency percentiles per operation, failed allocations
+// and the peak fragmentation of free space.
+//
+// Usage: mem_trace_replay <trace file> [pool size] [sample interval]
+// The pool size is only needed when the trace does not start with mem_init.
+
+#define DEFAULT_SAMPLE_INTERVAL 1000   // Operations between fragmentation samples
+#define OP_COUNT (MEM_TRACE_RESIZE + 1)
+
+const char* opNames[OP_COUNT] = { NULL, "init", "alloc", "batch", "free", "resize" };
+
+// Recorded block offset to the block it got in the replay. Open addressing
+// with linear probing; freed entries become tombstones, and the table is
+// sized for every insertion of the trace so it never fills up.
+typedef struct {
+    uint64_t offset;
+    void* block;   // NULL for a tombstone
+} BlockEntry;
+
+#define EMPTY_SLOT UINT64_MAX
+
+BlockEntry* blockTable = NULL;
+size_t blockTableMask = 0;
+
+// Latencies of one operation in nanoseconds
+typedef struct {
+    uint64_t* ns;
+    size_t count;
+} Latencies;
+
+Latencies latencies[OP_COUNT];
+
+// Replay results
+size_t failedAllocs = 0;      // Allocations that failed in the replay
+size_t tracedFailures = 0;    // Allocations that had failed when traced
+size_t unknownBlocks = 0;     // Frees and resizes of blocks not allocated in the trace
+size_t oversizedOps = 0;      // Sizes or counts too wide for this machine's size_t
+double peakFragmentation = 0.0;
+size_t peakFragmentationOp = 0;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static size_t slot_of(uint64_t offset) {
+    return (size_t)(offset * 0x9e3779b97f4a7c15ull >> 17) & blockTableMask;
+}
+
+static void map_block(uint64_t offset, void* block) {
+    size_t i = slot_of(offset);
+    while (blockTable[i].offset != EMPTY_SLOT && blockTable[i].offset != offset) i = (i + 1) & blockTableMask;
+    blockTable[i].offset = offset;
+    blockTable[i].block = block;
+}
+
+// Remove the mapping of offset and return its block, or NULL if there is none
+static void* unmap_block(uint64_t offset) {
+    size_t i = slot_of(offset);
+    while (blockTable[i].offset != EMPTY_SLOT) {
+        if (blockTable[i].offset == offset) {
+            void* block = blockTable[i].block;
+            blockTable[i].block = NULL;
+            return block;
+        }
+        i = (i + 1) & blockTableMask;
+    }
+    return NULL;
+}
+
+static int by_sequence(const void* a, const void* b) {
+    uint64_t x = ((const MemTraceRecord*)a)->sequence;
+    uint64_t y = ((const MemTraceRecord*)b)->sequence;
+    return (x > y) - (x < y);
+}
+
+static int by_value(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void sample_fragmentation(size_t op) {
+    MemFreeStats stats;
+    mem_free_stats(&stats);
+    if (stats.free_bytes == 0) return;
+    double fragmentation = 1.0 - (double)stats.largest_free / stats.free_bytes;
+    if (fragmentation > peakFragmentation) {
+        peakFragmentation = fragmentation;
+        peakFragmentationOp = op;
+    }
+}
+
+// Replay one record and return the time spent in the memory manager.
+// Frees and resizes of blocks the replay does not know are skipped, and so
+// are records whose size or batch count does not fit in a size_t here.
+static uint64_t replay(const MemTraceRecord* record) {
+    uint64_t start, end;
+    void* block;
+
+    if ((size_t)record->size != record->size ||
+        (record->op == MEM_TRACE_BATCH && (size_t)record->result != record->result)) {
+        oversizedOps++;
+        return 0;
+    }
+
+    switch (record->op) {
+    case MEM_TRACE_INIT:
+        for (size_t i = 0; i <= blockTableMask; i++) blockTable[i].block = NULL;
+        start = now_ns();
+        if (mem_pool_size() > 0) mem_deinit();
+        mem_init(record->size);
+        end = now_ns();
+        return end - start;
+    case MEM_TRACE_ALLOC:
+        start = now_ns();
+        block = mem_alloc(record->size);
+        end = now_ns();
+        if (record->block == MEM_TRACE_NONE) tracedFailures++;
+        if (block == NULL) failedAllocs++;
+        if (block != NULL && record->block != MEM_TRACE_NONE) map_block(record->block, block);
+        return end - start;
+    case MEM_TRACE_BATCH:
+        start = now_ns();
+        block = mem_alloc_batch(record->result, record->size);
+        end = now_ns();
+        if (record->block == MEM_TRACE_NONE) tracedFailures++;
+        if (block == NULL) failedAllocs++;
+        if (block != NULL && record->block != MEM_TRACE_NONE) {
+            for (uint64_t k = 0; k < record->result; k++) {
+                map_block(record->block + k * record->size, (char*)block + k * record->size);
+            }
+        }
+        return end - start;
+    case MEM_TRACE_FREE:
+        block = unmap_block(record->block);
+        if (block == NULL) {
+            unknownBlocks++;
+            return 0;
+        }
+        start = now_ns();
+        mem_free(block);
+        end = now_ns();
+        return end - start;
+    case MEM_TRACE_RESIZE: {
+        block = unmap_block(record->block);
+        if (block == NULL) {
+            unknownBlocks++;
+            return 0;
+        }
+        start = now_ns();
+        void* resized = mem_resize(block, record->size);
+        end = now_ns();
+        if (resized == NULL) {
+            failedAllocs++;
+            map_block(record->result != MEM_TRACE_NONE ? record->result : record->block, block);
+        } else {
+            map_block(record->result != MEM_TRACE_NONE ? record->result : record->block, resized);
+        }
+        return end - start;
+    }
+    }
+    return 0;
+}
+
+static uint64_t percentile(const Latencies* l, double p) {
+    size_t i = (size_t)(p * (l->count - 1));
+    return l->ns[i];
+}
+
+static void print_report(size_t replayed, uint64_t elapsed_ns) {
+    printf("Replayed %zu operations in %.3f ms (%.0f ops/s)\n", replayed, elapsed_ns / 1e6,
+           elapsed_ns > 0 ? replayed / (elapsed_ns / 1e9) : 0.0);
+    printf("Failed allocations: %zu (%zu when traced)\n", failedAllocs, tracedFailures);
+    if (unknownBlocks > 0) printf("Frees and resizes of untraced blocks skipped: %zu\n", unknownBlocks);
+    if (oversizedOps > 0) printf("Operations too large for this machine skipped: %zu\n", oversizedOps);
+    printf("Peak fragmentation %.3f after operation %zu\n\n", peakFragmentation, peakFragmentationOp);
+
+    printf("%8s %10s %10s %10s %10s %10s %10s\n", "op", "count", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "max_ns");
+    for (int op = MEM_TRACE_INIT; op < OP_COUNT; op++) {
+        Latencies* l = &latencies[op];
+        if (l->count == 0) continue;
+        qsort(l->ns, l->count, sizeof(uint64_t), by_value);
+        printf("%8s %10zu %10llu %10llu %10llu %10llu %10llu\n", opNames[op], l->count,
+               (unsigned long long)percentile(l, 0.5), (unsigned long long)percentile(l, 0.9),
+               (unsigned long long)percentile(l, 0.99), (unsigned long long)percentile(l, 0.999),
+               (unsigned long long)l->ns[l->count - 1]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2) {
+        printf("Usage: %s <trace file> [pool size] [sample interval]\n", argv[0]);
+        printf("Replays a trace written by mem_trace_start.\n");
+        return 1;
+    }
+    size_t poolSize = argc > 2 ? strtoull(argv[2], NULL, 0) : 0;
+    size_t sampleInterval = argc > 3 ? strtoull(argv[3], NULL, 0) : DEFAULT_SAMPLE_INTERVAL;
+    if (sampleInterval == 0) sampleInterval = DEFAULT_SAMPLE_INTERVAL;
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        printf("Error: Failed to open %s for reading.\n", argv[1]);
+        return 1;
+    }
+    MemTraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.magic != MEM_TRACE_MAGIC || header.version != MEM_TRACE_VERSION) {
+        printf("Error: %s is not an allocation trace.\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file) - (long)sizeof(header);
+    fseek(file, sizeof(header), SEEK_SET);
+    size_t count = (size_t)len / sizeof(MemTraceRecord);
+    MemTraceRecord* records = malloc((count > 0 ? count : 1) * sizeof(MemTraceRecord));
+    if (records == NULL || fread(records, sizeof(MemTraceRecord), count, file) != count) {
+        printf("Error: Failed to read %s.\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+    if (count == 0) {
+        printf("Error: %s has no records.\n", argv[1]);
+        return 1;
+    }
+
+    // Threads write their records in chunks, so restore the global order
+    qsort(records, count, sizeof(MemTraceRecord), by_sequence);
+    if (records[0].op != MEM_TRACE_INIT && poolSize == 0) {
+        printf("Error: The trace does not start with mem_init; give the pool size.\n");
+        return 1;
+    }
+
+    size_t insertions = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].op < MEM_TRACE_INIT || records[i].op >= OP_COUNT) {
+            printf("Error: Unknown operation %d in record %zu.\n", records[i].op, i);
+            return 1;
+        }
+        insertions += records[i].op == MEM_TRACE_BATCH ? records[i].result : 1;
+        latencies[records[i].op].count++;
+    }
+    size_t tableSize = 16;
+    while (tableSize < 2 * insertions) tableSize *= 2;
+    blockTable = malloc(tableSize * sizeof(BlockEntry));
+    for (int op = MEM_TRACE_INIT; op < OP_COUNT; op++) {
+        latencies[op].ns = malloc((latencies[op].count + 1) * sizeof(uint64_t));
+        latencies[op].count = 0;
+    }
+    if (blockTable == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    for (size_t i = 0; i < tableSize; i++) blockTable[i].offset = EMPTY_SLOT;
+    blockTableMask = tableSize - 1;
+
+    if (records[0].op != MEM_TRACE_INIT) mem_init(poolSize);
+
+    uint64_t elapsed = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t skipped = unknownBlocks;
+        uint64_t ns = replay(&records[i]);
+        elapsed += ns;
+        if (unknownBlocks == skipped) {
+            Latencies* l = &latencies[records[i].op];
+            l->ns[l->count++] = ns;
+        }
+        if ((i + 1) % sampleInterval == 0) sample_fragmentation(i);
+    }
+    sample_fragmentation(count - 1);
+
+    print_report(count, elapsed);
+
+    mem_deinit();
+    for (int op = MEM_TRACE_INIT; op < OP_COUNT; op++) free(latencies[op].ns);
+    free(blockTable);
+    free(records);
+    return 0;
+}
@@ -1,167 +1,1470 @@
+#define _GNU_SOURCE  // For sched_getcpu and thread affinity
 #include "memory_manager.h"
+#include "mem_profile.h"
+#include "mem_trace.h"
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sched.h>
+#include <sys/syscall.h>
 
-#define MAX_BLOCKS 1000 // Maximum number of blocks
-#define MIN_SIZE 16     // Minimum size for a block
+#define INITIAL_BLOCKS 1000 // Initial capacity of the metadata array
+#define MIN_SIZE 16         // Minimum size for a block
 
 // A struct to hold metadata of each block
 typedef struct {
     size_t size;
     int isFree;
+#ifdef MEM_DEBUG
+    int hasHeader;   // Allocated by mem_alloc and laid out by debug_wrap
+#endif
+    int handle;   // Owning handle for relocatable blocks, MEM_INVALID_HANDLE otherwise
 } BlockMeta;
 
+// A struct to hold the state of each relocatable handle
+typedef struct {
+    size_t offset;   // Current offset of the block in the pool
+    int lockCount;   // Number of outstanding mem_handle_lock calls
+    int inUse;
+} HandleEntry;
+
 // Global variables for memory management
 void* memoryPool = NULL;                 // Pointer to memory pool
-BlockMeta blockMetaArray[MAX_BLOCKS];    // Metadata array
+BlockMeta* blockMetaArray = NULL;        // Metadata array, grown on demand
+size_t blockCapacity = 0;                // Number of entries in the metadata array
 size_t pool_size = 0;                    // Size of the pool
-size_t blockCount = 0;                   // Number of blocks in the pool
+int poolIsMapped = 0;                    // Pool comes from mem_init_mapped and must be unmapped
+
+// Handle table for relocatable allocations
+HandleEntry* handleTable = NULL;
+size_t handleCapacity = 0;
+
+// State that every user of the pool must see. For mem_init_shared it lives at
+// the start of the shared memory segment, otherwise in localHeader.
+typedef struct {
+    pthread_mutex_t lock;   // Mutex for thread-safe memory manager operations
+    size_t blockCount;      // Number of blocks in the pool
+    size_t poolSize;        // Size of a shared pool, for processes that attach to it
+    size_t blockCapacity;   // Fixed metadata capacity of a shared pool
+    int ready;              // Set once the creator has initialized a shared pool
+} PoolHeader;
+
+PoolHeader localHeader = { PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, 0 };
+PoolHeader* poolHeader = &localHeader;
+
+// Shared memory segment backing the pool, if any
+void* sharedSegment = NULL;
+size_t sharedSegmentSize = 0;
+
+// Bumped whenever the pool is replaced or torn down, see mem_pool_generation
+unsigned long poolGeneration = 0;
+
+// Smallest free block a split may leave in the current pool, see mem_set_min_block
+size_t minBlockSize = MIN_SIZE;
+
+// Region of a pool from mem_init_numa whose pages live on one NUMA node
+typedef struct {
+    int id;             // Kernel node id
+    size_t offset;      // Page aligned start of the region in the pool
+    size_t size;
+    cpu_set_t cpus;     // CPUs of the node
+} NumaRegion;
+
+#define MPOL_BIND 2   // From linux/mempolicy.h
+
+NumaRegion numaRegions[MEM_NUMA_MAX_NODES];
+int numaRegionCount = 0;              // 0 unless the pool came from mem_init_numa
+signed char cpuRegion[CPU_SETSIZE];   // Region of each CPU, -1 if unknown
+
+#ifdef MEM_DEBUG
+// Debug builds (make mmanager-debug) surround every block from mem_alloc and
+// mem_resize with a header and guard bytes:
+//
+//   | state | size | front guard | caller's bytes | back guard |
+//
+// The state in the header catches a second mem_free of a pointer, including
+// two threads freeing it at once, mem_free verifies both guards, new bytes are filled with
+// DEBUG_ALLOC_BYTE and freed ones poisoned with DEBUG_FREE_BYTE. Blocks from
+// mem_alloc_batch and handles are left bare: callers index batches as arrays
+// and mem_compact moves handle blocks. Which blocks carry a header is kept in
+// BlockMeta.hasHeader; the bytes in front of a pointer are only read once the
+// metadata says a header is there, since a bare block can hold any value.
+#define DEBUG_LIVE 0x4c4956454d454d31ULL
+#define DEBUG_FREED 0x465245454d454d31ULL
+#define DEBUG_GUARD 16
+#define DEBUG_GUARD_BYTE 0xAB
+#define DEBUG_ALLOC_BYTE 0xCD
+#define DEBUG_FREE_BYTE 0xDD
+
+typedef struct {
+    uint64_t state;   // DEBUG_LIVE or DEBUG_FREED
+    size_t size;      // Size the caller asked for
+    unsigned char guard[DEBUG_GUARD];
+} DebugHeader;
+
+#define DEBUG_OVERHEAD (sizeof(DebugHeader) + DEBUG_GUARD)
+
+// Room for the overhead in pools sized for release blocks. A block of
+// DEBUG_SMALLEST_BLOCK bytes or more grows by at most DEBUG_POOL_SCALE once
+// DEBUG_OVERHEAD is added, so a pool that held such blocks in a release build
+// holds them in a debug build too; smaller blocks can run it out early.
+// Applied by mem_init, mem_init_shared and mem_init_numa; a mem_init_mapped
+// pool is the mapped file range and keeps its size.
+#define DEBUG_SMALLEST_BLOCK 8
+#define DEBUG_POOL_SCALE ((DEBUG_SMALLEST_BLOCK + DEBUG_OVERHEAD + DEBUG_SMALLEST_BLOCK - 1) / DEBUG_SMALLEST_BLOCK)
+
+// What the metadata says about a pointer passed to mem_free or mem_resize
+#define DEBUG_BARE 0        // No header belongs in front of it
+#define DEBUG_HAS_HEADER 1  // Starts the caller's part of a live mem_alloc block
+#define DEBUG_WAS_FREED 2   // Its header lies in free space and reads DEBUG_FREED
+
+MemDebugStats debugStats;
+
+#define DEBUG_COUNT(field) __atomic_fetch_add(&debugStats.field, 1, __ATOMIC_RELAXED)
+
+// Look up ptrs, sorted by address, in the block metadata in one pass and
+// store a DEBUG_BARE, DEBUG_HAS_HEADER or DEBUG_WAS_FREED for each in kinds.
+// Free space is only written by debug_unwrap and the poisoning, so a
+// DEBUG_FREED state found there was left by an earlier mem_free.
+static void debug_classify(void* const* ptrs, size_t count, unsigned char* kinds) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t i = 0;
+    size_t offset = 0;
+    for (size_t k = 0; k < count; k++) {
+        kinds[k] = DEBUG_BARE;
+        if ((char*)ptrs[k] < (char*)memoryPool + sizeof(DebugHeader) ||
+            (char*)ptrs[k] > (char*)memoryPool + pool_size) continue;
+
+        // Move on to the block holding the position of ptr's header
+        char* start = (char*)ptrs[k] - sizeof(DebugHeader);
+        while (i < poolHeader->blockCount && (char*)memoryPool + offset + blockMetaArray[i].size <= start) {
+            offset += blockMetaArray[i].size;
+            i++;
+        }
+        if (i == poolHeader->blockCount) continue;
+
+        char* block = (char*)memoryPool + offset;
+        if (!blockMetaArray[i].isFree) {
+            if (block == start && blockMetaArray[i].hasHeader) kinds[k] = DEBUG_HAS_HEADER;
+        } else if (start + sizeof(DebugHeader) <= block + blockMetaArray[i].size &&
+                   __atomic_load_n(&((DebugHeader*)start)->state, __ATOMIC_ACQUIRE) == DEBUG_FREED) {
+            kinds[k] = DEBUG_WAS_FREED;
+        }
+    }
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+}
+
+// Check that nothing wrote over either guard of a block
+static int debug_guards_intact(DebugHeader* header) {
+    unsigned char* back = (unsigned char*)(header + 1) + header->size;
+    if (back + DEBUG_GUARD > (unsigned char*)memoryPool + pool_size) return 0;
+
+    for (size_t k = 0; k < DEBUG_GUARD; k++) {
+        if (header->guard[k] != DEBUG_GUARD_BYTE || back[k] != DEBUG_GUARD_BYTE) return 0;
+    }
+    return 1;
+}
+
+// Lay out a freshly allocated block and return the caller's part of it
+static void* debug_wrap(void* block, size_t size) {
+    DebugHeader* header = block;
+    header->size = size;
+    memset(header->guard, DEBUG_GUARD_BYTE, DEBUG_GUARD);
+    memset(header + 1, DEBUG_ALLOC_BYTE, size);
+    memset((char*)(header + 1) + size, DEBUG_GUARD_BYTE, DEBUG_GUARD);
+    __atomic_store_n(&header->state, DEBUG_LIVE, __ATOMIC_RELEASE);
+    return header + 1;
+}
+
+// Check a pointer being freed, of the kind debug_classify found, and mark it
+// freed. Returns the block to release, ptr itself for blocks without a
+// header, or NULL when it was already freed.
+static void* debug_unwrap(void* ptr, unsigned char kind) {
+    if (kind == DEBUG_BARE) return ptr;
+
+    DebugHeader* header = (DebugHeader*)ptr - 1;
+    uint64_t expected = DEBUG_LIVE;
+    if (kind == DEBUG_WAS_FREED ||
+        !__atomic_compare_exchange_n(&header->state, &expected, DEBUG_FREED, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        DEBUG_COUNT(double_frees);
+        printf("Error: Double free of %p detected.\n", ptr);
+        return NULL;
+    }
+
+    if (!debug_guards_intact(header)) {
+        DEBUG_COUNT(overruns);
+        printf("Error: Guard bytes around %p were overwritten.\n", ptr);
+    } else {
+        memset(ptr, DEBUG_FREE_BYTE, header->size);
+    }
+    return header;
+}
+
+// Caller's view of allocated block i, for the iteration functions
+static char* debug_user_block(size_t i, char* block, size_t* size) {
+    if (!blockMetaArray[i].hasHeader) return block;
 
-// Mutex for thread-safe memory manager operations
-pthread_mutex_t memory_mutex = PTHREAD_MUTEX_INITIALIZER;
+    DebugHeader* header = (DebugHeader*)block;
+    if (size != NULL) *size = header->size;
+    return (char*)(header + 1);
+}
+
+#define DEBUG_POOL_SIZE(size) ((size) * DEBUG_POOL_SCALE)
+#define DEBUG_BLOCK_SIZE(size) ((size) + DEBUG_OVERHEAD)
+#define DEBUG_WRAP(block, size) debug_wrap(block, size)
+#define DEBUG_USER_BLOCK(i, block, size) debug_user_block(i, block, size)
+#define DEBUG_MARK_HEADER(i, has) (blockMetaArray[i].hasHeader = (has))
+#else
+// Release builds use blocks as they are
+#define DEBUG_POOL_SIZE(size) (size)
+#define DEBUG_BLOCK_SIZE(size) (size)
+#define DEBUG_WRAP(block, size) ((void*)(block))
+#define DEBUG_USER_BLOCK(i, block, size) (block)
+#define DEBUG_MARK_HEADER(i, has) ((void)0)
+#endif
+
+// Make room for extra more entries in the metadata array
+static int reserve_block_meta(size_t extra) {
+    if (poolHeader->blockCount + extra <= blockCapacity) return 1;
+    if (sharedSegment != NULL) return 0;  // Shared metadata cannot be reallocated
+
+    size_t newCapacity = blockCapacity ? blockCapacity : INITIAL_BLOCKS;
+    while (newCapacity < poolHeader->blockCount + extra) newCapacity *= 2;
+    BlockMeta* grown = realloc(blockMetaArray, newCapacity * sizeof(BlockMeta));
+    if (!grown) return 0;
+
+    blockMetaArray = grown;
+    blockCapacity = newCapacity;
+    return 1;
+}
+
+// Insert a metadata entry at index, keeping the array in address order
+static void insert_block_meta(size_t index, size_t size, int isFree) {
+    memmove(&blockMetaArray[index + 1], &blockMetaArray[index],
+            (poolHeader->blockCount - index) * sizeof(BlockMeta));
+    blockMetaArray[index].size = size;
+    blockMetaArray[index].isFree = isFree;
+    DEBUG_MARK_HEADER(index, 0);
+    blockMetaArray[index].handle = MEM_INVALID_HANDLE;
+    poolHeader->blockCount++;
+}
+
+// Remove the metadata entry at index
+static void remove_block_meta(size_t index) {
+    memmove(&blockMetaArray[index], &blockMetaArray[index + 1],
+            (poolHeader->blockCount - index - 1) * sizeof(BlockMeta));
+    poolHeader->blockCount--;
+}
+
+// Reset the metadata to a single free block covering the pool
+static void reset_block_meta(size_t size) {
+    poolHeader->blockCount = 0;
+    if (!reserve_block_meta(1)) {
+        printf("Failed to initialize block metadata.\n");
+        exit(1);
+    }
+
+    blockMetaArray[0].size = size;
+    blockMetaArray[0].isFree = 1;
+    DEBUG_MARK_HEADER(0, 0);
+    blockMetaArray[0].handle = MEM_INVALID_HANDLE;
+    poolHeader->blockCount = 1;
+    numaRegionCount = 0;  // mem_init_numa adds its regions afterwards
+    if (MEM_PROFILE_ACTIVE()) mem_profile_forget_live();
+    if (MEM_TRACE_ACTIVE()) mem_trace_record(MEM_TRACE_INIT, mem_trace_sequence(), 0, 0, size);
+
+    // Handles from a previous pool are no longer valid
+    if (handleTable) memset(handleTable, 0, handleCapacity * sizeof(HandleEntry));
+}
+
+// Drop a shared segment left attached and go back to process local state
+static void use_local_header() {
+    __atomic_add_fetch(&poolGeneration, 1, __ATOMIC_RELEASE);
+    minBlockSize = MIN_SIZE;
+    if (sharedSegment != NULL) {
+        munmap(sharedSegment, sharedSegmentSize);
+        sharedSegment = NULL;
+        sharedSegmentSize = 0;
+        blockMetaArray = NULL;
+        blockCapacity = 0;
+    }
+    poolHeader = &localHeader;
+}
 
 // Initialize the memory pool
 void mem_init(size_t size) {
-    pthread_mutex_init(&memory_mutex, NULL);  // Initialize the mutex
+    use_local_header();
+    pthread_mutex_init(&poolHeader->lock, NULL);  // Initialize the mutex
 
+    size = DEBUG_POOL_SIZE(size);
     memoryPool = malloc(size);
     pool_size = size;
+    poolIsMapped = 0;
     if (!memoryPool) {
         printf("Failed to initialize memory pool.\n");
         exit(1);
     }
 
-    blockMetaArray[0].size = size;
-    blockMetaArray[0].isFree = 1;
-    blockCount = 1;
+    reset_block_meta(size);
 
     printf("Memory pool initialized with size: %zu\n", size);
 }
 
-void* mem_alloc(size_t size) {
-    pthread_mutex_lock(&memory_mutex);  // Lock the mutex
+// Initialize the memory pool as a private (copy-on-write) mapping of size
+// bytes of fd starting at offset, which must be page aligned. The whole pool
+// starts out free; the file contents are visible through the blocks that are
+// allocated over them. The size is not scaled by DEBUG_POOL_SCALE in MEM_DEBUG
+// builds, so a mapping sized for exact release blocks may run out there.
+// Returns 0 on success and -1 if the mapping failed.
+int mem_init_mapped(int fd, off_t offset, size_t size) {
+    void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, offset);
+    if (mapped == MAP_FAILED) {
+        printf("Failed to map memory pool.\n");
+        return -1;
+    }
+
+    use_local_header();
+    pthread_mutex_init(&poolHeader->lock, NULL);  // Initialize the mutex
+
+    memoryPool = mapped;
+    pool_size = size;
+    poolIsMapped = 1;
+    reset_block_meta(size);
+
+    printf("Memory pool mapped with size: %zu\n", size);
+    return 0;
+}
+
+// Offsets of the metadata array and the pool within a shared segment
+static void shared_layout(size_t capacity, size_t* metaOffset, size_t* dataOffset) {
+    *metaOffset = (sizeof(PoolHeader) + 63) & ~(size_t)63;
+    *dataOffset = (*metaOffset + capacity * sizeof(BlockMeta) + 63) & ~(size_t)63;
+}
+
+// Create the named POSIX shared memory segment with a pool of size bytes, or
+// attach to it if another process already created it (size is then ignored).
+// The metadata and a process-shared mutex live in the segment, so every
+// attached process allocates from the same pool. Blocks are at different
+// addresses in each process; share them by offset from mem_pool_base().
+// Relocatable handles are process local and are not available.
+// Returns 0 on success and -1 on error.
+int mem_init_shared(const char* name, size_t size) {
+    size = DEBUG_POOL_SIZE(size);
+    int created = 1;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = 0;
+        fd = shm_open(name, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        printf("Failed to open shared memory segment %s.\n", name);
+        return -1;
+    }
+
+    // Every block is at least MIN_SIZE bytes, which bounds the metadata needed
+    size_t capacity = size / MIN_SIZE + 2;
+    size_t metaOffset, dataOffset;
+    shared_layout(capacity, &metaOffset, &dataOffset);
+
+    struct stat st;
+    if (created) {
+        if (ftruncate(fd, dataOffset + size) != 0) {
+            printf("Failed to size shared memory segment %s.\n", name);
+            close(fd);
+            shm_unlink(name);
+            return -1;
+        }
+        st.st_size = dataOffset + size;
+    } else {
+        // The creator may not have sized the segment yet
+        for (int tries = 0; fstat(fd, &st) == 0 && st.st_size == 0 && tries < 5000; tries++) {
+            usleep(1000);
+        }
+    }
 
+    void* segment = st.st_size > 0
+        ? mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (segment == MAP_FAILED) {
+        printf("Failed to map shared memory segment %s.\n", name);
+        return -1;
+    }
+
+    use_local_header();
+    PoolHeader* header = (PoolHeader*)segment;
+
+    if (created) {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutex_init(&header->lock, &attr);  // Initialize the mutex
+        pthread_mutexattr_destroy(&attr);
+
+        header->poolSize = size;
+        header->blockCapacity = capacity;
+    } else {
+        int tries = 0;
+        while (!__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE) && tries++ < 5000) {
+            usleep(1000);
+        }
+        if (!header->ready) {
+            printf("Shared memory segment %s was never initialized.\n", name);
+            munmap(segment, st.st_size);
+            return -1;
+        }
+        size = header->poolSize;
+        capacity = header->blockCapacity;
+        shared_layout(capacity, &metaOffset, &dataOffset);
+    }
+
+    sharedSegment = segment;
+    sharedSegmentSize = st.st_size;
+    poolHeader = header;
+    blockMetaArray = (BlockMeta*)((char*)segment + metaOffset);
+    blockCapacity = capacity;
+    memoryPool = (char*)segment + dataOffset;
+    pool_size = size;
+    poolIsMapped = 0;
+
+    if (created) {
+        reset_block_meta(size);
+        __atomic_store_n(&header->ready, 1, __ATOMIC_RELEASE);
+        printf("Shared memory pool %s created with size: %zu\n", name, size);
+    } else {
+        printf("Shared memory pool %s attached with size: %zu\n", name, size);
+    }
+    return 0;
+}
+
+// Remove the name of a shared pool. Attached processes keep their mapping.
+void mem_unlink_shared(const char* name) {
+    shm_unlink(name);
+}
+
+// Size of the current pool in bytes
+size_t mem_pool_size() {
+    return pool_size;
+}
+
+// Start of the current pool, for structures that link blocks by offset
+void* mem_pool_base() {
+    return memoryPool;
+}
+
+// Let splits in the current pool leave free blocks down to size bytes
+// instead of MIN_SIZE, for pools that hold objects smaller than that; every
+// init goes back to MIN_SIZE. Shared pools size their metadata by MIN_SIZE
+// and keep it. Returns 0 on success and -1 on error.
+int mem_set_min_block(size_t size) {
+    if (size == 0 || sharedSegment != NULL) {
+        printf("Error: Cannot set a minimum block size of %zu for this pool.\n", size);
+        return -1;
+    }
+
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+    minBlockSize = size;
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    return 0;
+}
+
+// Number that changes whenever the pool is initialized or deinitialized, so
+// code holding blocks for later, like the epoch limbo lists, can tell that
+// they belong to a pool that is gone
+unsigned long mem_pool_generation() {
+    return __atomic_load_n(&poolGeneration, __ATOMIC_ACQUIRE);
+}
+
+// Parse a sysfs list such as "0-3,8,10-11" into set. Returns 0 or -1.
+static int read_id_list(const char* path, cpu_set_t* set) {
+    CPU_ZERO(set);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return -1;
+
+    char line[4096];
+    int ok = fgets(line, sizeof(line), file) != NULL;
+    fclose(file);
+    if (!ok) return -1;
+
+    for (char* p = line; *p >= '0' && *p <= '9';) {
+        long first = strtol(p, &p, 10);
+        long last = *p == '-' ? strtol(p + 1, &p, 10) : first;
+        for (long id = first; id <= last && id < CPU_SETSIZE; id++) CPU_SET(id, set);
+        if (*p == ',') p++;
+    }
+    return 0;
+}
+
+// Fault in every page of a region, from a thread running on its node
+static void* touch_region(void* arg) {
+    NumaRegion* region = arg;
+    long page = sysconf(_SC_PAGESIZE);
+    volatile char* start = (char*)memoryPool + region->offset;
+    for (size_t i = 0; i < region->size; i += page) start[i] = 0;
+    return NULL;
+}
+
+// Initialize the memory pool with one region per NUMA node that has CPUs.
+// Each region is bound to its node with mbind and faulted in by a thread on
+// that node, so its pages are local to the node even where mbind is not
+// permitted. mem_alloc, mem_alloc_batch and a mem_resize that has to move
+// then take blocks from the region of the node the caller runs on, falling
+// back to the other regions when it is full; a resize that grows in place
+// may run past the end of its region. mem_free accepts blocks from any
+// region. All regions share the
+// pool lock. Returns the number of nodes, which is 1 on machines without
+// NUMA, or -1 if the pool could not be mapped.
+int mem_init_numa(size_t size) {
+    size = DEBUG_POOL_SIZE(size);
+    void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        printf("Failed to map memory pool.\n");
+        return -1;
+    }
+
+    use_local_header();
+    pthread_mutex_init(&poolHeader->lock, NULL);  // Initialize the mutex
+
+    memoryPool = mapped;
+    pool_size = size;
+    poolIsMapped = 1;
+    reset_block_meta(size);
+
+    // Nodes and their CPUs, or the whole machine as one node without sysfs
+    cpu_set_t nodes;
+    int count = 0;
+    memset(cpuRegion, -1, sizeof(cpuRegion));
+    if (read_id_list("/sys/devices/system/node/has_cpu", &nodes) == 0) {
+        for (int id = 0; id < MEM_NUMA_MAX_NODES; id++) {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+            if (!CPU_ISSET(id, &nodes) || read_id_list(path, &numaRegions[count].cpus) != 0) continue;
+            numaRegions[count++].id = id;
+        }
+    }
+    if (count == 0) {
+        numaRegions[0].id = 0;
+        sched_getaffinity(0, sizeof(cpu_set_t), &numaRegions[0].cpus);
+        count = 1;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    size_t regionSize = size / count / page * page;
+    int bound = count > 1;
+    for (int k = 0; k < count; k++) {
+        NumaRegion* region = &numaRegions[k];
+        region->offset = k * regionSize;
+        region->size = k + 1 < count ? regionSize : size - region->offset;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &region->cpus)) cpuRegion[cpu] = (signed char)k;
+        }
+
+        unsigned long mask = 1UL << region->id;
+        if (count > 1 && region->size > 0 &&
+            syscall(SYS_mbind, (char*)memoryPool + region->offset, region->size, MPOL_BIND,
+                    &mask, MEM_NUMA_MAX_NODES + 1, 0) != 0) {
+            bound = 0;
+        }
+    }
+
+    pthread_t threads[MEM_NUMA_MAX_NODES];
+    int started[MEM_NUMA_MAX_NODES];
+    for (int k = 0; k < count; k++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &numaRegions[k].cpus);
+        started[k] = pthread_create(&threads[k], &attr, touch_region, &numaRegions[k]) == 0;
+        pthread_attr_destroy(&attr);
+        if (!started[k]) touch_region(&numaRegions[k]);
+    }
+    for (int k = 0; k < count; k++) {
+        if (started[k]) pthread_join(threads[k], NULL);
+    }
+    numaRegionCount = count;
+
+    printf("Memory pool initialized with size: %zu on %d NUMA node(s)%s\n", size, count,
+           count > 1 && !bound ? ", placed by first touch" : "");
+    return count;
+}
+
+// Number of NUMA nodes of a pool from mem_init_numa, 0 for other pools
+int mem_numa_nodes() {
+    return numaRegionCount;
+}
+
+// Node index, from 0 to mem_numa_nodes() - 1, whose region holds block,
+// or -1 if block is not in a pool from mem_init_numa
+int mem_numa_node_of(void* block) {
+    size_t offset = (size_t)((char*)block - (char*)memoryPool);
+    if ((char*)block < (char*)memoryPool || offset >= pool_size) return -1;
+    for (int k = 0; k < numaRegionCount; k++) {
+        if (offset < numaRegions[k].offset + numaRegions[k].size) return k;
+    }
+    return -1;
+}
+
+// Restrict the calling thread to the CPUs of a node, so that its
+// allocations come from that node's region. Returns 0 or -1.
+int mem_numa_run_on_node(int node) {
+    if (node < 0 || node >= numaRegionCount) {
+        printf("Error: Invalid NUMA node %d.\n", node);
+        return -1;
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &numaRegions[node].cpus) == 0 ? 0 : -1;
+}
+
+// Mark free block i allocated, splitting off what is left beyond size.
+// Returns 0 when the metadata array cannot grow to hold the split.
+static int claim_block(size_t i, size_t size) {
+    size_t remainingSize = blockMetaArray[i].size - size;
+    DEBUG_MARK_HEADER(i, 0);
+
+    // If the remaining size can fit a new block, split it
+    if (remainingSize >= minBlockSize) {
+        if (!reserve_block_meta(1)) return 0;
+
+        blockMetaArray[i].size = size;
+        blockMetaArray[i].isFree = 0;  // Mark the block as allocated
+
+        // Create a new free block from the remaining space, right after this one
+        insert_block_meta(i + 1, remainingSize, 1);
+    } else {
+        // If the block is exactly the right size or cannot be split, allocate the entire block
+        blockMetaArray[i].isFree = 0;
+    }
+    return 1;
+}
+
+// Region of the CPU the caller runs on, or -1
+static int local_region() {
+    int cpu = sched_getcpu();
+    return cpu >= 0 && cpu < CPU_SETSIZE ? cpuRegion[cpu] : -1;
+}
+
+// First fit within a NUMA region while holding the pool lock. A free block
+// that reaches into the region from the one before is split at the region
+// start, so the returned block begins at *outOffset inside the region.
+static long find_free_block_in(const NumaRegion* region, size_t size, size_t* outOffset) {
+    size_t start = region->offset;
+    size_t end = region->offset + region->size;
     size_t offset = 0;
-    for (size_t i = 0; i < blockCount; ++i) {
-        if (blockMetaArray[i].isFree && blockMetaArray[i].size >= size) {
-            size_t remainingSize = blockMetaArray[i].size - size;
-
-            // If the remaining size can fit a new block, split it
-            if (remainingSize >= MIN_SIZE) {
-                blockMetaArray[i].size = size;
-                blockMetaArray[i].isFree = 0;  // Mark the block as allocated
-
-                // Create a new block from the remaining space
-                blockMetaArray[blockCount].size = remainingSize;
-                blockMetaArray[blockCount].isFree = 1;  // Mark the new block as free
-                blockCount++;
-            } else {
-                // If the block is exactly the right size or cannot be split, allocate the entire block
-                blockMetaArray[i].isFree = 0;
+    for (size_t i = 0; i < poolHeader->blockCount && offset < end; ++i) {
+        size_t blockEnd = offset + blockMetaArray[i].size;
+        if (blockMetaArray[i].isFree && blockEnd > start) {
+            // A prefix too small to stand alone stays with the block
+            size_t from = offset < start && start - offset >= minBlockSize ? start : offset;
+            if ((blockEnd < end ? blockEnd : end) >= from + size) {
+                if (from > offset) {
+                    if (!reserve_block_meta(1)) return -1;
+                    insert_block_meta(i, from - offset, 1);
+                    blockMetaArray[++i].size -= from - offset;
+                }
+                *outOffset = from;
+                return (long)i;
             }
+        }
+        offset = blockEnd;
+    }
+    return -1;
+}
+
+// Find a free block of at least size bytes while holding the pool lock,
+// storing its offset in *outOffset. A pool from mem_init_numa is searched
+// from the caller's node first and falls back to the other nodes when it
+// is full.
+static long find_free_block(size_t size, size_t* outOffset) {
+    if (numaRegionCount > 1) {
+        int region = local_region();
+        long index = region >= 0 ? find_free_block_in(&numaRegions[region], size, outOffset) : -1;
+        if (index >= 0) return index;
+    }
 
-            pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-            return (char*)memoryPool + offset;
+    size_t offset = 0;
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        if (blockMetaArray[i].isFree && blockMetaArray[i].size >= size) {
+            *outOffset = offset;
+            return (long)i;
         }
 
         // Update the offset to point to the next block
         offset += blockMetaArray[i].size;
     }
 
-    pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-    printf("Error: No suitable block found for size %zu\n", size);
+    return -1;
+}
+
+// Allocate a block while holding the pool lock, storing its offset in *outOffset
+static long alloc_block(size_t size, size_t* outOffset) {
+    long i = find_free_block(size, outOffset);
+    if (i < 0 || !claim_block((size_t)i, size)) return -1;
+    return i;
+}
+
+// Find the block starting at ptr while holding the pool lock
+static long find_block(void* ptr) {
+    size_t offset = 0;
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        if ((char*)memoryPool + offset == (char*)ptr) return (long)i;
+        offset += blockMetaArray[i].size;
+    }
+    return -1;
+}
+
+// Total free bytes, number of free blocks and the largest free block
+void mem_free_stats(MemFreeStats* stats) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        if (blockMetaArray[i].isFree) {
+            stats->free_bytes += blockMetaArray[i].size;
+            stats->free_blocks++;
+            if (blockMetaArray[i].size > stats->largest_free) stats->largest_free = blockMetaArray[i].size;
+        }
+    }
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+}
+
+// Report a failed allocation with enough detail to tell an exhausted pool
+// from a fragmented one
+static void report_no_block(size_t size) {
+    MemFreeStats stats;
+    mem_free_stats(&stats);
+    printf("Error: No suitable block found for size %zu (%zu bytes free in %zu blocks, largest %zu)\n",
+           size, stats.free_bytes, stats.free_blocks, stats.largest_free);
+}
+
+void* mem_alloc(size_t size) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t offset;
+    long index = alloc_block(DEBUG_BLOCK_SIZE(size), &offset);
+    if (index >= 0) DEBUG_MARK_HEADER(index, 1);
+    int tracing = MEM_TRACE_ACTIVE();
+    uint64_t sequence = tracing ? mem_trace_sequence() : 0;
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+
+    if (tracing) mem_trace_record(MEM_TRACE_ALLOC, sequence, index < 0 ? MEM_TRACE_NONE : offset, 0, size);
+    if (index < 0) {
+        report_no_block(size);
+        return NULL;
+    }
+
+    void* block = DEBUG_WRAP((char*)memoryPool + offset, size);
+    if (MEM_PROFILE_ACTIVE()) mem_profile_note_alloc(block, size);
+    return block;
+}
+
+// Allocate count blocks of size bytes laid out back to back, each of which
+// can later be passed to mem_free on its own. Returns the first block.
+void* mem_alloc_batch(size_t count, size_t size) {
+    if (count == 0) return NULL;
+
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t total = count * size;
+    size_t offset;
+    long found = find_free_block(total, &offset);
+    if (found >= 0 && reserve_block_meta(count)) {
+        size_t i = (size_t)found;
+        size_t remainingSize = blockMetaArray[i].size - total;
+        int split = remainingSize >= minBlockSize;
+
+        // Open a gap for the new entries in one move
+        size_t extra = count - 1 + split;
+        memmove(&blockMetaArray[i + 1 + extra], &blockMetaArray[i + 1],
+                (poolHeader->blockCount - i - 1) * sizeof(BlockMeta));
+        poolHeader->blockCount += extra;
+
+        for (size_t k = 0; k < count; k++) {
+            blockMetaArray[i + k].size = size;
+            blockMetaArray[i + k].isFree = 0;
+            DEBUG_MARK_HEADER(i + k, 0);
+            blockMetaArray[i + k].handle = MEM_INVALID_HANDLE;
+        }
+        if (split) {
+            blockMetaArray[i + count].size = remainingSize;
+            blockMetaArray[i + count].isFree = 1;
+            DEBUG_MARK_HEADER(i + count, 0);
+            blockMetaArray[i + count].handle = MEM_INVALID_HANDLE;
+        } else {
+            // Too small to stand alone, give the slack to the last block
+            blockMetaArray[i + count - 1].size += remainingSize;
+        }
+
+        int tracing = MEM_TRACE_ACTIVE();
+        uint64_t sequence = tracing ? mem_trace_sequence() : 0;
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+
+        if (tracing) mem_trace_record(MEM_TRACE_BATCH, sequence, offset, count, size);
+        return (char*)memoryPool + offset;
+    }
+
+    int tracing = MEM_TRACE_ACTIVE();
+    uint64_t sequence = tracing ? mem_trace_sequence() : 0;
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+
+    if (tracing) mem_trace_record(MEM_TRACE_BATCH, sequence, MEM_TRACE_NONE, count, size);
+    printf("Error: No suitable block found for %zu blocks of size %zu\n", count, size);
     return NULL;
 }
 
+// Mark block i free and merge it with free neighbours
+static void release_block(size_t i) {
+    blockMetaArray[i].isFree = 1;
+    DEBUG_MARK_HEADER(i, 0);
+    blockMetaArray[i].handle = MEM_INVALID_HANDLE;
+
+    if (i + 1 < poolHeader->blockCount && blockMetaArray[i + 1].isFree) {
+        blockMetaArray[i].size += blockMetaArray[i + 1].size;
+        remove_block_meta(i + 1);
+    }
+
+    if (i > 0 && blockMetaArray[i - 1].isFree) {
+        blockMetaArray[i - 1].size += blockMetaArray[i].size;
+        remove_block_meta(i);
+    }
+}
 
 // Free allocated memory
 void mem_free(void* ptr) {
+    if (ptr != NULL && MEM_PROFILE_ACTIVE()) mem_profile_note_free(ptr);
+#ifdef MEM_DEBUG
+    if (ptr != NULL) {
+        unsigned char kind;
+        debug_classify(&ptr, 1, &kind);
+        ptr = debug_unwrap(ptr, kind);
+    }
+#endif
     if (ptr == NULL) return;
 
-    pthread_mutex_lock(&memory_mutex);  // Lock the mutex
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    long i = find_block(ptr);
+    if (i >= 0) {
+        release_block((size_t)i);
+    }
+    int tracing = i >= 0 && MEM_TRACE_ACTIVE();
+    uint64_t sequence = tracing ? mem_trace_sequence() : 0;
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    if (tracing) mem_trace_record(MEM_TRACE_FREE, sequence, (char*)ptr - (char*)memoryPool, 0, 0);
+    if (i < 0) {
+#ifdef MEM_DEBUG
+        DEBUG_COUNT(invalid_pointers);
+#endif
+        printf("Error: Pointer not found in memory pool.\n");
+    }
+}
+
+// Order pointers by address for mem_free_batch
+static int compare_ptrs(const void* a, const void* b) {
+    char* x = *(char* const*)a;
+    char* y = *(char* const*)b;
+    return (x > y) - (x < y);
+}
+
+// Free count blocks under a single lock. ptrs is sorted in place so the
+// whole batch is matched in one pass over the metadata. NULL entries are
+// skipped; a pointer listed more than once is freed once and reported.
+void mem_free_batch(void** ptrs, size_t count) {
+    if (ptrs == NULL || count == 0) return;
+    if (MEM_PROFILE_ACTIVE()) {
+        for (size_t k = 0; k < count; k++) {
+            if (ptrs[k] != NULL) mem_profile_note_free(ptrs[k]);
+        }
+    }
+#ifdef MEM_DEBUG
+    // Look the whole batch up in one pass over the metadata, then unwrap.
+    // Blocks already freed become NULL, which the pass below skips.
+    qsort(ptrs, count, sizeof(void*), compare_ptrs);
+    unsigned char* kinds = malloc(count);
+    if (kinds != NULL) debug_classify(ptrs, count, kinds);
+    for (size_t k = 0; k < count; k++) {
+        if (ptrs[k] == NULL) continue;
+        unsigned char kind;
+        if (kinds == NULL) debug_classify(&ptrs[k], 1, &kind);
+        ptrs[k] = debug_unwrap(ptrs[k], kinds != NULL ? kinds[k] : kind);
+    }
+    free(kinds);
+#endif
+    qsort(ptrs, count, sizeof(void*), compare_ptrs);
+
+    // Sequence and offset of each freed block, recorded once the lock is
+    // dropped. Without the room the records are written under the lock.
+    int tracing = MEM_TRACE_ACTIVE();
+    uint64_t* traced = tracing ? malloc(2 * count * sizeof(uint64_t)) : NULL;
+    size_t tracedCount = 0;
 
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t next = 0;
     size_t offset = 0;
-    for (size_t i = 0; i < blockCount; ++i) {
-        if ((char*)memoryPool + offset == (char*)ptr) {
-            blockMetaArray[i].isFree = 1;
-
-            if (i + 1 < blockCount && blockMetaArray[i + 1].isFree) {
-                blockMetaArray[i].size += blockMetaArray[i + 1].size;
-                for (size_t j = i + 1; j < blockCount - 1; ++j) {
-                    blockMetaArray[j] = blockMetaArray[j + 1];
-                }
-                blockCount--;
-            }
+    size_t i = 0;
+    size_t missing = 0;
+    size_t duplicates = 0;
+    while (next < count && i < poolHeader->blockCount) {
+        char* start = (char*)memoryPool + offset;
+        if (ptrs[next] != NULL && next > 0 && ptrs[next] == ptrs[next - 1]) {
+            // Sorting put the copies side by side; the first one was freed
+            duplicates++;
+            next++;
+            continue;
+        }
+        if (ptrs[next] == NULL || (char*)ptrs[next] < start) {
+            // NULL or a pointer into the middle of a block
+            if (ptrs[next] != NULL) missing++;
+            next++;
+            continue;
+        }
 
-            if (i > 0 && blockMetaArray[i - 1].isFree) {
-                blockMetaArray[i - 1].size += blockMetaArray[i].size;
-                for (size_t j = i; j < blockCount - 1; ++j) {
-                    blockMetaArray[j] = blockMetaArray[j + 1];
-                }
-                blockCount--;
+        if ((char*)ptrs[next] == start && blockMetaArray[i].isFree) {
+            // Not allocated, freed before this batch
+            missing++;
+            next++;
+            continue;
+        }
+        if ((char*)ptrs[next] == start) {
+            int mergesBack = i > 0 && blockMetaArray[i - 1].isFree;
+            size_t prevSize = mergesBack ? blockMetaArray[i - 1].size : 0;
+            release_block(i);
+            if (traced != NULL) {
+                traced[2 * tracedCount] = mem_trace_sequence();
+                traced[2 * tracedCount + 1] = offset;
+                tracedCount++;
+            } else if (tracing) {
+                mem_trace_record(MEM_TRACE_FREE, mem_trace_sequence(), offset, 0, 0);
+            }
+            if (mergesBack) {
+                // Block i became part of its free predecessor
+                i--;
+                offset -= prevSize;
             }
+            next++;
+            continue;
+        }
+
+        offset += blockMetaArray[i].size;
+        i++;
+    }
+    missing += count - next;
 
-            pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-            return;
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    for (size_t k = 0; k < tracedCount; k++) {
+        mem_trace_record(MEM_TRACE_FREE, traced[2 * k], traced[2 * k + 1], 0, 0);
+    }
+    free(traced);
+    if (duplicates > 0) {
+#ifdef MEM_DEBUG
+        __atomic_fetch_add(&debugStats.double_frees, duplicates, __ATOMIC_RELAXED);
+#endif
+        printf("Error: %zu pointers listed more than once in a batch free.\n", duplicates);
+    }
+    if (missing > 0) {
+#ifdef MEM_DEBUG
+        __atomic_fetch_add(&debugStats.invalid_pointers, missing, __ATOMIC_RELAXED);
+#endif
+        printf("Error: %zu pointers not found in memory pool.\n", missing);
+    }
+}
+
+// Resize memory. Everything happens in one critical section: a single pass
+// over the metadata finds both the block and the first free block that could
+// take the new size, so a move costs one search and one copy.
+static void* resize_block(void* ptr, size_t newSize, uint64_t* sequence) {
+
+#ifdef MEM_DEBUG
+    // Guarded blocks always move, so stale pointers to the old copy show up
+    unsigned char kind;
+    debug_classify(&ptr, 1, &kind);
+    if (kind != DEBUG_BARE) {
+        DebugHeader* header = (DebugHeader*)ptr - 1;
+        if (kind == DEBUG_WAS_FREED || __atomic_load_n(&header->state, __ATOMIC_ACQUIRE) != DEBUG_LIVE) {
+            DEBUG_COUNT(invalid_pointers);
+            printf("Error: Resize of freed block %p.\n", ptr);
+            return NULL;
         }
+        void* moved = mem_alloc(newSize);
+        if (moved == NULL) return NULL;
+        memcpy(moved, ptr, header->size < newSize ? header->size : newSize);
+        mem_free(ptr);
+        return moved;
+    }
+#endif
 
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+    if (MEM_TRACE_ACTIVE()) *sequence = mem_trace_sequence();
+
+    long index = -1;
+    long target = -1;
+    size_t targetOffset = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < poolHeader->blockCount && (index < 0 || target < 0); ++i) {
+        if (index < 0 && (char*)memoryPool + offset == (char*)ptr) {
+            index = (long)i;
+        } else if (target < 0 && blockMetaArray[i].isFree && blockMetaArray[i].size >= newSize) {
+            target = (long)i;
+            targetOffset = offset;
+        }
         offset += blockMetaArray[i].size;
     }
 
-    pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-    printf("Error: Pointer not found in memory pool.\n");
+    if (index < 0) {
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        printf("Error: Pointer not found in memory pool for resize.\n");
+        return NULL;
+    }
+
+    size_t i = (size_t)index;
+    size_t oldSize = blockMetaArray[i].size;
+    if (oldSize >= newSize) {
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        return ptr;
+    }
+
+    if (i + 1 < poolHeader->blockCount && blockMetaArray[i + 1].isFree &&
+        oldSize + blockMetaArray[i + 1].size >= newSize) {
+        // Take only what is needed from the free neighbour; absorb it whole
+        // when the rest would be too small to stand as a block
+        size_t needed = newSize - oldSize;
+        if (blockMetaArray[i + 1].size - needed >= minBlockSize) {
+            blockMetaArray[i].size = newSize;
+            blockMetaArray[i + 1].size -= needed;
+        } else {
+            blockMetaArray[i].size += blockMetaArray[i + 1].size;
+            remove_block_meta(i + 1);
+        }
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        return ptr;
+    }
+
+    size_t countBefore = poolHeader->blockCount;
+    if (numaRegionCount > 1) {
+        // Move within the caller's node, like a fresh allocation would
+        target = find_free_block(newSize, &targetOffset);
+        // A split at the region start shifts the old block's index by one
+        if (target >= 0 && (size_t)target <= i && poolHeader->blockCount > countBefore) {
+            i++;
+        }
+        countBefore = poolHeader->blockCount;
+    }
+    if (target < 0 || !claim_block((size_t)target, newSize)) {
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        report_no_block(newSize);
+        return NULL;
+    }
+
+    // A split in front of the old block shifts its index by one
+    if ((size_t)target < i && poolHeader->blockCount > countBefore) {
+        i++;
+    }
+
+    void* newBlock = (char*)memoryPool + targetOffset;
+    memcpy(newBlock, ptr, oldSize);
+    release_block(i);
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    return newBlock;
 }
 
-// Resize memory
 void* mem_resize(void* ptr, size_t newSize) {
     if (ptr == NULL) return mem_alloc(newSize);
 
-    pthread_mutex_lock(&memory_mutex);  // Lock the mutex
+    // A sampled block keeps the call site it was allocated from
+    int site;
+    size_t weight;
+    int sampled = MEM_PROFILE_ACTIVE() && mem_profile_take(ptr, &site, &weight);
+
+    uint64_t sequence = 0;
+    void* resized = resize_block(ptr, newSize, &sequence);
+
+    if (sampled) {
+        if (resized != NULL && newSize > weight) weight = newSize;
+        mem_profile_put(resized != NULL ? resized : ptr, site, weight);
+    }
+    // Blocks that do not take the traced path are traced as their alloc and free
+    if (sequence != 0) {
+        mem_trace_record(MEM_TRACE_RESIZE, sequence, (char*)ptr - (char*)memoryPool,
+                         resized != NULL ? (uint64_t)((char*)resized - (char*)memoryPool) : MEM_TRACE_NONE,
+                         newSize);
+    }
+    return resized;
+}
+
+// Call visit for every allocated block in address order, stopping early when
+// it returns nonzero. The pool lock is held throughout, so visit must not
+// call back into the memory manager. Returns the number of blocks visited.
+size_t mem_foreach_allocated(mem_visit_fn visit, void* ctx) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
 
+    size_t visited = 0;
     size_t offset = 0;
-    for (size_t i = 0; i < blockCount; ++i) {
-        if ((char*)memoryPool + offset == (char*)ptr) {
-            BlockMeta* block = &blockMetaArray[i];
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        if (!blockMetaArray[i].isFree) {
+            size_t size = blockMetaArray[i].size;
+            char* block = DEBUG_USER_BLOCK(i, (char*)memoryPool + offset, &size);
+            visited++;
+            if (visit(block, size, ctx)) break;
+        }
+        offset += blockMetaArray[i].size;
+    }
 
-            if (block->size >= newSize) {
-                pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-                return ptr;
-            }
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    return visited;
+}
 
-            if (i + 1 < blockCount && blockMetaArray[i + 1].isFree) {
-                BlockMeta* nextBlock = &blockMetaArray[i + 1];
-                if (block->size + nextBlock->size >= newSize) {
-                    block->size += nextBlock->size;
-                    blockMetaArray[i + 1].isFree = 0;
-                    pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-                    return ptr;
-                }
-            }
+// Copy the addresses of up to cap allocated blocks into out, in address
+// order. Returns the total number of allocated blocks, which may exceed cap.
+size_t mem_allocated_blocks(void** out, size_t cap) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t found = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        if (!blockMetaArray[i].isFree) {
+            if (found < cap) out[found] = DEBUG_USER_BLOCK(i, (char*)memoryPool + offset, NULL);
+            found++;
+        }
+        offset += blockMetaArray[i].size;
+    }
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    return found;
+}
+
+// Find the metadata index of the block owned by handle
+static long find_handle_block(mem_handle_t handle) {
+    if (handle < 0 || (size_t)handle >= handleCapacity || !handleTable[handle].inUse) return -1;
+
+    size_t offset = 0;
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        if (offset == handleTable[handle].offset) {
+            // Skip zero sized blocks sharing the same offset
+            if (blockMetaArray[i].handle == handle) return (long)i;
+        }
+        offset += blockMetaArray[i].size;
+    }
+    return -1;
+}
+
+// Allocate a relocatable block
+mem_handle_t mem_handle_alloc(size_t size) {
+    if (sharedSegment != NULL) {
+        printf("Error: Handles are not supported in a shared pool.\n");
+        return MEM_INVALID_HANDLE;
+    }
+
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    // Find an unused handle slot, growing the table when it is full
+    size_t h = 0;
+    while (h < handleCapacity && handleTable[h].inUse) h++;
+    if (h == handleCapacity) {
+        size_t newCapacity = handleCapacity ? handleCapacity * 2 : 64;
+        HandleEntry* grown = realloc(handleTable, newCapacity * sizeof(HandleEntry));
+        if (!grown) {
+            pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+            printf("Error: Failed to grow handle table.\n");
+            return MEM_INVALID_HANDLE;
+        }
+        memset(grown + handleCapacity, 0, (newCapacity - handleCapacity) * sizeof(HandleEntry));
+        handleTable = grown;
+        handleCapacity = newCapacity;
+    }
+
+    size_t offset;
+    long index = alloc_block(size, &offset);
+    if (index < 0) {
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        printf("Error: No suitable block found for size %zu\n", size);
+        return MEM_INVALID_HANDLE;
+    }
+
+    blockMetaArray[index].handle = (int)h;
+    handleTable[h].offset = offset;
+    handleTable[h].lockCount = 0;
+    handleTable[h].inUse = 1;
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    return (mem_handle_t)h;
+}
+
+// Pin a relocatable block and return its current address
+void* mem_handle_lock(mem_handle_t handle) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
 
-            void* new_block = mem_alloc(newSize);
-            if (new_block != NULL) {
-                memcpy(new_block, ptr, block->size);
-                mem_free(ptr);
+    if (handle < 0 || (size_t)handle >= handleCapacity || !handleTable[handle].inUse) {
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        printf("Error: Invalid handle %d.\n", handle);
+        return NULL;
+    }
+
+    handleTable[handle].lockCount++;
+    void* ptr = (char*)memoryPool + handleTable[handle].offset;
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+    return ptr;
+}
+
+// Unpin a relocatable block, allowing mem_compact to move it again
+void mem_handle_unlock(mem_handle_t handle) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    if (handle < 0 || (size_t)handle >= handleCapacity || !handleTable[handle].inUse
+        || handleTable[handle].lockCount == 0) {
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        printf("Error: Handle %d is not locked.\n", handle);
+        return;
+    }
+
+    handleTable[handle].lockCount--;
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+}
+
+// Free a relocatable block
+void mem_handle_free(mem_handle_t handle) {
+    if (handle == MEM_INVALID_HANDLE) return;
+
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    long index = find_handle_block(handle);
+    if (index < 0) {
+        pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+        printf("Error: Invalid handle %d.\n", handle);
+        return;
+    }
+
+    release_block((size_t)index);
+    handleTable[handle].inUse = 0;
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+}
+
+// Slide unlocked handle blocks towards the start of the pool so free space
+// collects in as few blocks as possible. Plain mem_alloc blocks and locked
+// handles are pinned and act as barriers.
+void mem_compact(MemCompactStats* stats) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t bytesMoved = 0;
+    size_t blocksMoved = 0;
+    size_t offset = 0;
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        // Bubble the free block at i forward past every movable block behind it
+        while (blockMetaArray[i].isFree && i + 1 < poolHeader->blockCount) {
+            BlockMeta next = blockMetaArray[i + 1];
+            if (next.isFree) {
+                blockMetaArray[i].size += next.size;
+                remove_block_meta(i + 1);
+                continue;
             }
+            if (next.handle == MEM_INVALID_HANDLE || handleTable[next.handle].lockCount > 0) break;
+
+            char* dst = (char*)memoryPool + offset;
+            memmove(dst, dst + blockMetaArray[i].size, next.size);
+            handleTable[next.handle].offset = offset;
 
-            pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-            return new_block;
+            blockMetaArray[i + 1] = blockMetaArray[i];
+            blockMetaArray[i] = next;
+            bytesMoved += next.size;
+            blocksMoved++;
+
+            offset += next.size;
+            i++;
         }
 
         offset += blockMetaArray[i].size;
     }
 
-    pthread_mutex_unlock(&memory_mutex);  // Unlock the mutex
-    printf("Error: Pointer not found in memory pool for resize.\n");
-    return NULL;
+    size_t freeBytes = 0;
+    size_t largestFree = 0;
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        if (blockMetaArray[i].isFree) {
+            freeBytes += blockMetaArray[i].size;
+            if (blockMetaArray[i].size > largestFree) largestFree = blockMetaArray[i].size;
+        }
+    }
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (stats) {
+        stats->bytes_moved = bytesMoved;
+        stats->blocks_moved = blocksMoved;
+        stats->free_bytes = freeBytes;
+        stats->largest_free_block = largestFree;
+        stats->elapsed_ns = (unsigned long long)(end.tv_sec - start.tv_sec) * 1000000000ULL
+                            + (end.tv_nsec - start.tv_nsec);
+    }
+}
+
+// Write all of buf to fd, retrying short writes. Returns 0 or -1.
+static int write_all(int fd, const void* buf, size_t len) {
+    const char* p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Snapshot the block layout and write it to fd, as CSV rows of
+// offset,size,state under a '#' line with the time and pool size, or as one
+// binary MemMapHeader plus a record per block (MEM_MAP_BINARY). Snapshots
+// appended to one file can be read back by mem_map_analyze to follow
+// fragmentation over time. The lock is only held while the metadata is
+// copied. Returns 0 on success and -1 on error.
+int mem_dump_map(int fd, int format) {
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t count = poolHeader->blockCount;
+    uint64_t* records = malloc((count ? count : 1) * sizeof(uint64_t));
+    if (records != NULL) {
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t state = blockMetaArray[i].isFree ? MEM_MAP_FREE
+                : blockMetaArray[i].handle != MEM_INVALID_HANDLE ? MEM_MAP_HANDLE : MEM_MAP_USED;
+            records[i] = (uint64_t)blockMetaArray[i].size << 2 | state;
+        }
+    }
+    size_t poolSize = pool_size;
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+
+    if (records == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    MemMapHeader header = { MEM_MAP_MAGIC, MEM_MAP_VERSION,
+                            (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec,
+                            poolSize, count };
+
+    int failed;
+    if (format == MEM_MAP_BINARY) {
+        failed = write_all(fd, &header, sizeof(header)) != 0 ||
+                 write_all(fd, records, count * sizeof(uint64_t)) != 0;
+    } else {
+        static const char* stateNames[] = { "free", "used", "handle" };
+        char buffer[4096];
+        size_t len = (size_t)snprintf(buffer, sizeof(buffer),
+                                      "# mem_map timestamp_ns=%llu pool_size=%zu blocks=%zu\noffset,size,state\n",
+                                      (unsigned long long)header.timestamp_ns, poolSize, count);
+        failed = 0;
+        uint64_t offset = 0;
+        for (size_t i = 0; i < count && !failed; ++i) {
+            // Flush when the next row might not fit
+            if (len + 64 > sizeof(buffer)) {
+                failed = write_all(fd, buffer, len) != 0;
+                len = 0;
+            }
+            uint64_t size = records[i] >> 2;
+            len += (size_t)snprintf(buffer + len, sizeof(buffer) - len, "%llu,%llu,%s\n",
+                                    (unsigned long long)offset, (unsigned long long)size,
+                                    stateNames[records[i] & 3]);
+            offset += size;
+        }
+        if (!failed) failed = write_all(fd, buffer, len) != 0;
+    }
+
+    free(records);
+    if (failed) {
+        printf("Error: Failed to write the heap map.\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Copy the errors a MEM_DEBUG build has caught so far. Always zero in
+// release builds, which do not check.
+void mem_debug_stats(MemDebugStats* stats) {
+#ifdef MEM_DEBUG
+    stats->overruns = __atomic_load_n(&debugStats.overruns, __ATOMIC_RELAXED);
+    stats->double_frees = __atomic_load_n(&debugStats.double_frees, __ATOMIC_RELAXED);
+    stats->invalid_pointers = __atomic_load_n(&debugStats.invalid_pointers, __ATOMIC_RELAXED);
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+// Verify the guard bytes of every live block from mem_alloc and report the
+// ones that were overwritten. Returns the number of damaged blocks, always 0
+// in release builds.
+size_t mem_debug_check() {
+    size_t damaged = 0;
+#ifdef MEM_DEBUG
+    pthread_mutex_lock(&poolHeader->lock);  // Lock the mutex
+
+    size_t offset = 0;
+    for (size_t i = 0; i < poolHeader->blockCount; ++i) {
+        char* block = (char*)memoryPool + offset;
+        if (!blockMetaArray[i].isFree && blockMetaArray[i].hasHeader &&
+            !debug_guards_intact((DebugHeader*)block)) {
+            damaged++;
+            printf("Error: Guard bytes around %p were overwritten.\n", (void*)((DebugHeader*)block + 1));
+        }
+        offset += blockMetaArray[i].size;
+    }
+
+    pthread_mutex_unlock(&poolHeader->lock);  // Unlock the mutex
+#endif
+    return damaged;
 }
 
 // Deinitialize the memory pool
 void mem_deinit() {
-    pthread_mutex_destroy(&memory_mutex);  // Destroy the mutex
+    if (MEM_PROFILE_ACTIVE()) mem_profile_forget_live();
+
+    if (sharedSegment != NULL) {
+        // Other processes may still use the shared pool, only detach from it
+        use_local_header();
+        memoryPool = NULL;
+        pool_size = 0;
 
-    free(memoryPool);
+        printf("Shared memory pool detached.\n");
+        return;
+    }
+
+    pthread_mutex_destroy(&poolHeader->lock);  // Destroy the mutex
+    __atomic_add_fetch(&poolGeneration, 1, __ATOMIC_RELEASE);
+
+    if (poolIsMapped) {
+        munmap(memoryPool, pool_size);
+    } else {
+        free(memoryPool);
+    }
     memoryPool = NULL;
     pool_size = 0;
-    blockCount = 0;
+    poolIsMapped = 0;
+    numaRegionCount = 0;
+    poolHeader->blockCount = 0;
+
+    free(blockMetaArray);
+    blockMetaArray = NULL;
+    blockCapacity = 0;
+
+    free(handleTable);
+    handleTable = NULL;
+    handleCapacity = 0;
 
     printf("Memory pool deinitialized.\n");
 }
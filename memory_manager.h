@@ -5,6 +5,21 @@
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>  // Required for mutexes
+#include <sys/types.h>
+#include <stdint.h>
+
+// Handle to a relocatable block, see mem_handle_alloc
+typedef int mem_handle_t;
+#define MEM_INVALID_HANDLE (-1)
+
+// Statistics reported by mem_compact
+typedef struct {
+    size_t bytes_moved;              // Bytes copied while sliding blocks
+    size_t blocks_moved;             // Number of blocks relocated
+    size_t free_bytes;               // Total free bytes after compaction
+    size_t largest_free_block;       // Largest contiguous free block after compaction
+    unsigned long long elapsed_ns;   // Wall time spent in mem_compact
+} MemCompactStats;
 
 // Memory manager functions
 void mem_init(size_t size);
@@ -13,4 +28,87 @@ void mem_free(void* block);
 void* mem_resize(void* block, size_t size);
 void mem_deinit();
 
+// Map a page aligned region of a file as the pool, see memory_manager.c
+int mem_init_mapped(int fd, off_t offset, size_t size);
+size_t mem_pool_size();
+
+// Create or attach to a pool in named POSIX shared memory, see memory_manager.c
+int mem_init_shared(const char* name, size_t size);
+void mem_unlink_shared(const char* name);
+void* mem_pool_base();
+unsigned long mem_pool_generation();
+int mem_set_min_block(size_t size);
+
+// Create a pool with one region per NUMA node; allocations come from the
+// caller's node, see memory_manager.c
+#define MEM_NUMA_MAX_NODES 64
+int mem_init_numa(size_t size);
+int mem_numa_nodes();
+int mem_numa_node_of(void* block);
+int mem_numa_run_on_node(int node);
+
+// Allocate count contiguous blocks of size bytes that are freed individually
+void* mem_alloc_batch(size_t count, size_t size);
+
+// Free many blocks while taking the pool lock once. Reorders ptrs.
+void mem_free_batch(void** ptrs, size_t count);
+
+// Free space of the pool, see mem_free_stats
+typedef struct {
+    size_t free_bytes;
+    size_t free_blocks;
+    size_t largest_free;
+} MemFreeStats;
+
+void mem_free_stats(MemFreeStats* stats);
+
+// Addresses of allocated blocks in address order, see memory_manager.c
+size_t mem_allocated_blocks(void** out, size_t cap);
+
+// Visit allocated blocks in address order; return nonzero from visit to stop
+typedef int (*mem_visit_fn)(void* block, size_t size, void* ctx);
+size_t mem_foreach_allocated(mem_visit_fn visit, void* ctx);
+
+// Relocatable allocations. The block behind a handle may be moved by
+// mem_compact unless it is locked; pointers from mem_handle_lock are only
+// valid until the matching mem_handle_unlock.
+mem_handle_t mem_handle_alloc(size_t size);
+void* mem_handle_lock(mem_handle_t handle);
+void mem_handle_unlock(mem_handle_t handle);
+void mem_handle_free(mem_handle_t handle);
+
+// Slide unlocked handle blocks together to merge free space. stats may be NULL.
+void mem_compact(MemCompactStats* stats);
+
+// Errors caught by a MEM_DEBUG build (make mmanager-debug), see memory_manager.c
+typedef struct {
+    size_t overruns;           // Blocks freed with damaged guard bytes
+    size_t double_frees;       // Frees of blocks that were already freed
+    size_t invalid_pointers;   // Frees and resizes of pointers not from the pool
+} MemDebugStats;
+
+void mem_debug_stats(MemDebugStats* stats);
+size_t mem_debug_check();
+
+// Heap map export, see mem_dump_map. A binary snapshot is a MemMapHeader
+// followed by block_count uint64_t records of size << 2 | state, in address
+// order; offsets are the running sum of the sizes.
+#define MEM_MAP_CSV 0
+#define MEM_MAP_BINARY 1
+#define MEM_MAP_MAGIC 0x50414d4dU   // "MMAP"
+#define MEM_MAP_VERSION 1
+#define MEM_MAP_FREE 0
+#define MEM_MAP_USED 1
+#define MEM_MAP_HANDLE 2            // Relocatable block owned by a handle
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t timestamp_ns;   // CLOCK_REALTIME when the snapshot was taken
+    uint64_t pool_size;
+    uint64_t block_count;
+} MemMapHeader;
+
+int mem_dump_map(int fd, int format);
+
 #endif // MEMORY_MANAGER_H
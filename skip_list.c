@@ -0,0 +1,195 @@
+#include "memory_manager.h"
+#include "skip_list.h"
+#include "list_format.h"
+
+#define NODE_SIZE(level) (sizeof(SkipNode) + (level) * sizeof(SkipNode*))
+
+// Pick a node height with P(level > k) = 1/2^k
+static int random_level(SkipList* list) {
+    // xorshift32
+    uint32_t x = list->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    list->seed = x;
+
+    int level = 1 + __builtin_ctz(x | (1u << (SKIP_MAX_LEVEL - 1)));
+    return level;
+}
+
+// Initialize the skip list and a memory pool for about size elements.
+// Returns 0 on success and -1 if the sentinel could not be allocated, in
+// which case the list stays empty and inserts fail.
+int skiplist_init(SkipList* list, size_t size) {
+    // Nodes average two forward pointers; budget four so taller nodes still fit,
+    // plus a few full height nodes of slack so small lists survive an unlucky run
+    mem_init(5 * NODE_SIZE(SKIP_MAX_LEVEL) + size * NODE_SIZE(4));
+
+    pthread_mutex_init(&list->mutex, NULL);
+    list->level = 1;
+    list->count = 0;
+    list->seed = 0x9E3779B9u ^ (uint32_t)(uintptr_t)list;
+
+    list->head = (SkipNode*)mem_alloc(NODE_SIZE(SKIP_MAX_LEVEL));
+    if (list->head == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+    list->head->level = SKIP_MAX_LEVEL;
+    for (int i = 0; i < SKIP_MAX_LEVEL; i++) {
+        list->head->next[i] = NULL;
+    }
+    return 0;
+}
+
+// Fill update[] with the last node before data on every level. A list
+// without a sentinel is empty and fills nothing.
+static SkipNode* find_predecessors(SkipList* list, uint16_t data, SkipNode** update) {
+    SkipNode* current = list->head;
+    if (current == NULL) return NULL;
+    for (int i = list->level - 1; i >= 0; i--) {
+        while (current->next[i] != NULL && current->next[i]->data < data) {
+            current = current->next[i];
+        }
+        if (update != NULL) update[i] = current;
+    }
+    return current->next[0];
+}
+
+// Insert a new node, after any nodes with equal data
+void skiplist_insert(SkipList* list, uint16_t data) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    if (list->head == NULL) {
+        printf("Error: Skip list is not initialized.\n");
+        pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+        return;
+    }
+
+    int level = random_level(list);
+    SkipNode* new_node = (SkipNode*)mem_alloc(NODE_SIZE(level));
+    if (new_node == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+        return;
+    }
+    new_node->data = data;
+    new_node->level = level;
+
+    SkipNode* update[SKIP_MAX_LEVEL];
+    SkipNode* current = list->head;
+    for (int i = list->level - 1; i >= 0; i--) {
+        while (current->next[i] != NULL && current->next[i]->data <= data) {
+            current = current->next[i];
+        }
+        update[i] = current;
+    }
+    for (int i = list->level; i < level; i++) {
+        update[i] = list->head;
+    }
+    if (level > list->level) list->level = level;
+
+    for (int i = 0; i < level; i++) {
+        new_node->next[i] = update[i]->next[i];
+        update[i]->next[i] = new_node;
+    }
+    list->count++;
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+}
+
+// Delete the first node with the specified data
+void skiplist_delete(SkipList* list, uint16_t data) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    SkipNode* update[SKIP_MAX_LEVEL];
+    SkipNode* target = find_predecessors(list, data, update);
+    if (target == NULL || target->data != data) {
+        printf("Error: Node with data %u not found.\n", data);
+        pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+        return;
+    }
+
+    for (int i = 0; i < target->level; i++) {
+        update[i]->next[i] = target->next[i];
+    }
+    while (list->level > 1 && list->head->next[list->level - 1] == NULL) {
+        list->level--;
+    }
+    list->count--;
+
+    mem_free(target);
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+}
+
+// Search for the first node with the specified data
+SkipNode* skiplist_search(SkipList* list, uint16_t data) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    SkipNode* found = find_predecessors(list, data, NULL);
+    if (found != NULL && found->data != data) found = NULL;
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return found;
+}
+
+// Find the first node with data >= the given value, the start of a range iteration
+SkipNode* skiplist_lower_bound(SkipList* list, uint16_t data) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    SkipNode* found = find_predecessors(list, data, NULL);
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return found;
+}
+
+// Step to the following node in order
+SkipNode* skiplist_next(SkipNode* node) {
+    return node != NULL ? node->next[0] : NULL;
+}
+
+// Display all values in [low, high] in the same format as list_display_range
+void skiplist_display_range(SkipList* list, uint16_t low, uint16_t high) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    ListPrinter printer;
+    list_print_begin(&printer);
+    SkipNode* current = find_predecessors(list, low, NULL);
+    while (current != NULL && current->data <= high) {
+        SkipNode* next = current->next[0];
+        list_print_element(&printer, current->data, next == NULL || next->data > high);
+        current = next;
+    }
+    list_print_end(&printer);
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+}
+
+// Count the elements in the list
+size_t skiplist_count(SkipList* list) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+    size_t count = list->count;
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    return count;
+}
+
+// Clean up the skip list, including the sentinel
+void skiplist_cleanup(SkipList* list) {
+    pthread_mutex_lock(&list->mutex);  // Lock the mutex
+
+    if (list->head != NULL) {
+        SkipNode* current = list->head->next[0];
+        while (current != NULL) {
+            SkipNode* next = current->next[0];
+            mem_free(current);
+            current = next;
+        }
+        mem_free(list->head);
+    }
+    list->head = NULL;
+    list->level = 1;
+    list->count = 0;
+
+    pthread_mutex_unlock(&list->mutex);  // Unlock the mutex
+    pthread_mutex_destroy(&list->mutex);
+}
@@ -0,0 +1,38 @@
+#ifndef SKIP_LIST_H
+#define SKIP_LIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define SKIP_MAX_LEVEL 16 // Maximum height of a node
+
+// Struct for nodes in the skip list. Nodes are allocated from the memory pool
+// with room for exactly `level` forward pointers.
+typedef struct SkipNode {
+    uint16_t data;
+    uint8_t level;
+    struct SkipNode* next[];
+} SkipNode;
+
+// An ordered list with O(log n) search, insert and delete by value
+typedef struct {
+    SkipNode* head;        // Sentinel with SKIP_MAX_LEVEL forward pointers
+    int level;             // Current height of the tallest node
+    size_t count;          // Number of elements
+    uint32_t seed;         // State for choosing node heights
+    pthread_mutex_t mutex;
+} SkipList;
+
+int skiplist_init(SkipList* list, size_t size);
+void skiplist_insert(SkipList* list, uint16_t data);
+void skiplist_delete(SkipList* list, uint16_t data);
+SkipNode* skiplist_search(SkipList* list, uint16_t data);
+SkipNode* skiplist_lower_bound(SkipList* list, uint16_t data);
+SkipNode* skiplist_next(SkipNode* node);
+void skiplist_display_range(SkipList* list, uint16_t low, uint16_t high);
+size_t skiplist_count(SkipList* list);
+void skiplist_cleanup(SkipList* list);
+
+#endif // SKIP_LIST_H
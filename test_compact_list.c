@@ -0,0 +1,191 @@
+#include "memory_manager.h"
+#include "compact_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// ********* Test basic compact list operations *********
+
+void test_clist_node_size()
+{
+    printf_yellow("  Testing compact node size ---> ");
+    my_assert(sizeof(CompactNode) == 8);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_insert()
+{
+    printf_yellow("  Testing clist_insert and clist_insert_after ---> ");
+    NodeRef head;
+    clist_init(&head, 3);
+    clist_insert(&head, 10);
+    clist_insert(&head, 30);
+    clist_insert_after(head, 20);
+
+    CompactNode *node = clist_node(head);
+    my_assert(node->data == 10);
+    node = clist_node(node->next);
+    my_assert(node->data == 20);
+    node = clist_node(node->next);
+    my_assert(node->data == 30);
+    my_assert(node->next == NODE_REF_NULL);
+    my_assert(clist_count_nodes(&head) == 3);
+
+    clist_cleanup(&head);
+    my_assert(head == NODE_REF_NULL);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_delete_search()
+{
+    printf_yellow("  Testing clist_delete and clist_search ---> ");
+    NodeRef head;
+    clist_init(&head, 3);
+    clist_insert(&head, 10);
+    clist_insert(&head, 20);
+    clist_insert(&head, 30);
+
+    my_assert(clist_node(clist_search(&head, 20))->data == 20);
+    my_assert(clist_search(&head, 40) == NODE_REF_NULL);
+
+    clist_delete(&head, 10);
+    my_assert(clist_node(head)->data == 20);
+    clist_delete(&head, 30);
+    my_assert(clist_node(head)->next == NODE_REF_NULL);
+    clist_delete(&head, 20);
+    my_assert(head == NODE_REF_NULL);
+    my_assert(clist_count_nodes(&head) == 0);
+
+    clist_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_clist_relocation(int count)
+{
+    printf_yellow("  Testing compact list after moving the pool ---> ");
+    NodeRef head;
+    clist_init(&head, count);
+    for (int i = 0; i < count; i++)
+    {
+        clist_insert(&head, i);
+    }
+
+    // Copy the pool into a new pool at a different address
+    size_t size = mem_pool_size();
+    void *saved = malloc(size);
+    memcpy(saved, mem_pool_base(), size);
+    void *oldBase = mem_pool_base();
+    mem_deinit();
+    void *keepBusy = malloc(size); // Take the old address so the new pool lands elsewhere
+    mem_init(size);
+    my_assert(mem_pool_base() != oldBase);
+    memcpy(mem_pool_base(), saved, size);
+
+    // The links are offsets, so the list is intact without any fixups
+    NodeRef ref = head;
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(clist_node(ref)->data == i);
+        ref = clist_node(ref)->next;
+    }
+    my_assert(ref == NODE_REF_NULL);
+
+    free(saved);
+    free(keepBusy);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+void test_clist_shared_pool()
+{
+    printf_yellow("  Testing two compact lists in one pool ---> ");
+    NodeRef a, b = NODE_REF_NULL;
+    clist_init(&a, 8);
+    clist_insert(&a, 1);
+    clist_insert(&a, 2);
+    clist_insert(&a, 3);
+    my_assert(clist_count_nodes(&a) == 3);
+    clist_insert(&b, 7);
+    clist_insert(&b, 9);
+    clist_insert_after(b, 8);
+
+    my_assert(clist_count_nodes(&a) == 3);
+    my_assert(clist_count_nodes(&b) == 3);
+    clist_delete(&a, 2);
+    my_assert(clist_count_nodes(&a) == 2);
+
+    clist_cleanup(&b);
+    my_assert(clist_count_nodes(&b) == 0);
+    my_assert(clist_count_nodes(&a) == 2);
+    clist_cleanup(&a);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_clist_node_size - Check the node is 8 bytes\n");
+        printf(" 2. test_clist_insert - Test insert and insert after\n");
+        printf(" 3. test_clist_delete_search - Test delete and search\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 4. test_clist_relocation - Test the list survives moving the pool\n");
+        printf(" 5. test_clist_shared_pool - Test two lists allocating from one pool\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_clist_node_size();
+        test_clist_insert();
+        test_clist_delete_search();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_clist_relocation(1000);
+        test_clist_shared_pool();
+        break;
+    case 1:
+        test_clist_node_size();
+        break;
+    case 2:
+        test_clist_insert();
+        break;
+    case 3:
+        test_clist_delete_search();
+        break;
+    case 4:
+        test_clist_relocation(1000);
+        break;
+    case 5:
+        test_clist_shared_pool();
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
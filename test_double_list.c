@@ -0,0 +1,205 @@
+#include "memory_manager.h"
+#include "double_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Capture the output of dlist_display or dlist_display_reverse
+void capture_dlist_display(char *buffer, size_t size, DList *list, int reverse)
+{
+    FILE *tempFile = fopen("temp_output.txt", "w+");
+    if (tempFile == NULL)
+    {
+        printf("Failed to open temporary file for capturing stdout.\n");
+        return;
+    }
+
+    FILE *original_stdout = stdout;
+    stdout = tempFile;
+    if (reverse)
+    {
+        dlist_display_reverse(list);
+    }
+    else
+    {
+        dlist_display(list);
+    }
+    fflush(stdout);
+    stdout = original_stdout;
+
+    rewind(tempFile);
+    size_t n = fread(buffer, 1, size - 1, tempFile);
+    buffer[n] = '\0';
+    fclose(tempFile);
+}
+
+// ********* Test basic doubly linked list operations *********
+
+void test_dlist_push()
+{
+    printf_yellow("  Testing dlist_push_front, dlist_push_back and dlist_insert_after ---> ");
+    DList list;
+    dlist_init(&list, 4);
+    DNode *twenty = dlist_push_back(&list, 20);
+    dlist_push_front(&list, 10);
+    dlist_push_back(&list, 40);
+    dlist_insert_after(&list, twenty, 30);
+
+    char buffer[64];
+    capture_dlist_display(buffer, sizeof(buffer), &list, 0);
+    my_assert(strcmp(buffer, "[10, 20, 30, 40]") == 0);
+    my_assert(dlist_count(&list) == 4);
+    my_assert(dlist_first(&list)->data == 10);
+    my_assert(dlist_last(&list)->data == 40);
+
+    dlist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_dlist_backward()
+{
+    printf_yellow("  Testing backward iteration ---> ");
+    DList list;
+    dlist_init(&list, 5);
+    for (int i = 1; i <= 5; i++)
+    {
+        dlist_push_back(&list, i);
+    }
+
+    int expected = 5;
+    for (DNode *node = dlist_last(&list); node != NULL; node = dlist_prev(node))
+    {
+        my_assert(node->data == expected);
+        expected--;
+    }
+    my_assert(expected == 0);
+
+    char buffer[64];
+    capture_dlist_display(buffer, sizeof(buffer), &list, 1);
+    my_assert(strcmp(buffer, "[5, 4, 3, 2, 1]") == 0);
+
+    dlist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_dlist_remove_node()
+{
+    printf_yellow("  Testing dlist_remove_node ---> ");
+    DList list;
+    dlist_init(&list, 5);
+    DNode *nodes[5];
+    for (int i = 0; i < 5; i++)
+    {
+        nodes[i] = dlist_push_back(&list, 10 * (i + 1));
+    }
+
+    char buffer[64];
+    dlist_remove_node(&list, dlist_search(&list, 30)); // Middle
+    capture_dlist_display(buffer, sizeof(buffer), &list, 0);
+    my_assert(strcmp(buffer, "[10, 20, 40, 50]") == 0);
+
+    my_assert(dlist_remove_node(&list, nodes[0]) == 0); // Head
+    my_assert(dlist_remove_node(&list, nodes[4]) == 0); // Tail
+    capture_dlist_display(buffer, sizeof(buffer), &list, 0);
+    my_assert(strcmp(buffer, "[20, 40]") == 0);
+
+    // Removing a node twice is refused and leaves the neighbours alone
+    my_assert(dlist_remove_node(&list, nodes[0]) == -1);
+    my_assert(dlist_remove_node(&list, nodes[2]) == -1);
+    my_assert(dlist_count(&list) == 2);
+    capture_dlist_display(buffer, sizeof(buffer), &list, 1);
+    my_assert(strcmp(buffer, "[40, 20]") == 0);
+
+    dlist_remove_node(&list, nodes[1]);
+    dlist_remove_node(&list, nodes[3]);
+    my_assert(dlist_first(&list) == NULL && dlist_last(&list) == NULL);
+    my_assert(dlist_count(&list) == 0);
+
+    dlist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_dlist_move_to_front()
+{
+    printf_yellow("  Testing dlist_move_to_front ---> ");
+    DList list;
+    dlist_init(&list, 3);
+    DNode *first = dlist_push_back(&list, 1);
+    dlist_push_back(&list, 2);
+    DNode *last = dlist_push_back(&list, 3);
+
+    char buffer[64];
+    dlist_move_to_front(&list, last);
+    capture_dlist_display(buffer, sizeof(buffer), &list, 0);
+    my_assert(strcmp(buffer, "[3, 1, 2]") == 0);
+    dlist_move_to_front(&list, last); // Already at the front
+    dlist_move_to_front(&list, first);
+    capture_dlist_display(buffer, sizeof(buffer), &list, 0);
+    my_assert(strcmp(buffer, "[1, 3, 2]") == 0);
+    capture_dlist_display(buffer, sizeof(buffer), &list, 1);
+    my_assert(strcmp(buffer, "[2, 3, 1]") == 0);
+    my_assert(dlist_count(&list) == 3);
+
+    dlist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_dlist_push - Test inserting at both ends and after a node\n");
+        printf(" 2. test_dlist_backward - Test iterating from the tail\n");
+        printf(" 3. test_dlist_remove_node - Test removing held nodes\n");
+        printf(" 4. test_dlist_move_to_front - Test moving a node to the front\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_dlist_push();
+        test_dlist_backward();
+        test_dlist_remove_node();
+        test_dlist_move_to_front();
+        break;
+    case 1:
+        test_dlist_push();
+        break;
+    case 2:
+        test_dlist_backward();
+        break;
+    case 3:
+        test_dlist_remove_node();
+        break;
+    case 4:
+        test_dlist_move_to_front();
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
@@ -1,9 +1,12 @@
+#include "memory_manager.h"
 #include "linked_list.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 #include <time.h>
 #include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "common_defs.h"
 #include "gitdata.h"
@@ -469,6 +472,667 @@ void test_list_edge_cases()
     printf_green("[PASS].\n");
 }
 
+// ********* Sorted operations *********
+
+void test_list_insert_sorted()
+{
+    printf_yellow("  Testing list_insert_sorted ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 5);
+    list_insert_sorted(&head, 30);
+    list_insert_sorted(&head, 10);
+    list_insert_sorted(&head, 40);
+    list_insert_sorted(&head, 20);
+    list_insert_sorted(&head, 5);
+
+    uint16_t expected[] = {5, 10, 20, 30, 40};
+    Node *current = head;
+    for (int i = 0; i < 5; i++)
+    {
+        my_assert(current->data == expected[i]);
+        current = current->next;
+    }
+    my_assert(current == NULL);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_sort(int count)
+{
+    printf_yellow("  Testing list_sort ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_insert(&head, rand() % 1000);
+    }
+
+    list_sort(&head);
+
+    int n = 0;
+    for (Node *current = head; current != NULL; current = current->next)
+    {
+        if (current->next != NULL)
+        {
+            my_assert(current->data <= current->next->data);
+        }
+        n++;
+    }
+    my_assert(n == count);
+
+    // Sorting an empty list is a no-op
+    Node *empty = NULL;
+    list_sort(&empty);
+    my_assert(empty == NULL);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_merge_sorted()
+{
+    printf_yellow("  Testing list_merge_sorted ---> ");
+    Node *head = NULL;
+    Node *other = NULL;
+    list_init(&head, sizeof(Node) * 6);
+    list_insert(&head, 10);
+    list_insert(&head, 30);
+    list_insert(&head, 50);
+    list_insert(&other, 20);
+    list_insert(&other, 30);
+    list_insert(&other, 60);
+
+    Node *first30 = head->next;
+    list_merge_sorted(&head, &other);
+    my_assert(other == NULL);
+
+    uint16_t expected[] = {10, 20, 30, 30, 50, 60};
+    Node *current = head;
+    for (int i = 0; i < 6; i++)
+    {
+        my_assert(current->data == expected[i]);
+        current = current->next;
+    }
+    my_assert(current == NULL);
+    my_assert(head->next->next == first30); // Equal values keep head's node first
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+// ********* Serialization *********
+
+void test_list_to_buffer()
+{
+    printf_yellow("  Testing list_to_buffer ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 3);
+
+    char buffer[64];
+    my_assert(list_to_buffer(&head, buffer, sizeof(buffer)) == 2);
+    my_assert(strcmp(buffer, "[]") == 0);
+
+    list_insert(&head, 0);
+    list_insert(&head, 65535);
+    list_insert(&head, 42);
+    my_assert(list_to_buffer(&head, buffer, sizeof(buffer)) == 14);
+    my_assert(strcmp(buffer, "[0, 65535, 42]") == 0);
+
+    // A short buffer is truncated and still reports the full length
+    char small[8];
+    my_assert(list_to_buffer(&head, small, sizeof(small)) == 14);
+    my_assert(strcmp(small, "[0, 655") == 0);
+    my_assert(list_to_buffer(&head, NULL, 0) == 14);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+// Deletes the first elements of a list while test_list_write_fd streams it
+static void *delete_front_worker(void *arg)
+{
+    Node **head = arg;
+    for (int i = 0; i < 2000 && *head != NULL; i++)
+    {
+        list_delete(head, (*head)->data);
+    }
+    return NULL;
+}
+
+void test_list_write_fd(int count)
+{
+    printf_yellow("  Testing list_write_fd ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_insert(&head, (i * 7919) % 65536);
+    }
+
+    FILE *tempFile = tmpfile();
+    my_assert(tempFile != NULL);
+    my_assert(list_write_fd(&head, fileno(tempFile)) == 0);
+
+    // The output must match list_to_buffer byte for byte
+    size_t len = list_to_buffer(&head, NULL, 0);
+    char *expected = malloc(len + 1);
+    char *written = malloc(len + 1);
+    list_to_buffer(&head, expected, len + 1);
+    rewind(tempFile);
+    my_assert(fread(written, 1, len + 1, tempFile) == len);
+    my_assert(memcmp(written, expected, len) == 0);
+
+    // Writers may unlink nodes between chunks; the output stays well formed
+    rewind(tempFile);
+    my_assert(ftruncate(fileno(tempFile), 0) == 0);
+    pthread_t deleter;
+    pthread_create(&deleter, NULL, delete_front_worker, &head);
+    my_assert(list_write_fd(&head, fileno(tempFile)) == 0);
+    pthread_join(deleter, NULL);
+    long size = lseek(fileno(tempFile), 0, SEEK_END);
+    my_assert(size > 1 && (size_t)size <= len);
+    my_assert(pread(fileno(tempFile), written, size, 0) == size);
+    my_assert(written[0] == '[' && written[size - 1] == ']');
+    for (long i = 1; i < size - 1; i++)
+    {
+        my_assert((written[i] >= '0' && written[i] <= '9') || written[i] == ',' || written[i] == ' ');
+    }
+
+    free(expected);
+    free(written);
+    fclose(tempFile);
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_save_load(int count)
+{
+    printf_yellow("  Testing list_save and list_load ---> ");
+    const char *path = "temp_list_snapshot.bin";
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * (count + 1));
+    for (int i = 0; i < count; i++)
+    {
+        list_insert(&head, (i * 31) % 65536);
+    }
+    list_delete(&head, 0); // Leave a hole so pool order and list order differ
+    my_assert(list_save(&head, path) == 0);
+    list_cleanup(&head);
+    mem_deinit();
+
+    Node *loaded = NULL;
+    my_assert(list_load(&loaded, path) == 0);
+    my_assert(list_count_nodes(&loaded) == count - 1);
+    Node *current = loaded;
+    for (int i = 1; i < count; i++)
+    {
+        my_assert(current->data == (i * 31) % 65536);
+        current = current->next;
+    }
+    my_assert(current == NULL);
+
+    // The loaded pool keeps the original capacity for further inserts
+    list_insert(&loaded, 7);
+    list_insert(&loaded, 8);
+    list_delete(&loaded, 31);
+    my_assert(list_count_nodes(&loaded) == count);
+    my_assert(loaded->data == 62);
+
+    list_cleanup(&loaded);
+    mem_deinit();
+    remove(path);
+
+    my_assert(list_load(&loaded, "missing_snapshot.bin") == -1);
+    my_assert(loaded == NULL);
+    printf_green("[PASS].\n");
+}
+
+// Patch bytes of a snapshot file in place
+static void patch_file(const char *path, long offset, const void *bytes, size_t len)
+{
+    FILE *file = fopen(path, "r+b");
+    my_assert(file != NULL);
+    fseek(file, offset, SEEK_SET);
+    my_assert(fwrite(bytes, 1, len, file) == len);
+    fclose(file);
+}
+
+void test_list_load_corrupt()
+{
+    printf_yellow("  Testing list_load of damaged snapshots ---> ");
+    const char *path = "temp_list_corrupt.bin";
+    Node *head = NULL;
+    Node *loaded = NULL;
+
+    // Header fields: magic and node size, then count, data offset and pool size
+    uint64_t count = 0, dataOffset = 0;
+    list_init(&head, 8);
+    for (int i = 0; i < 4; i++)
+    {
+        list_insert(&head, i);
+    }
+    my_assert(list_save(&head, path) == 0);
+    list_cleanup(&head);
+    mem_deinit();
+    FILE *file = fopen(path, "rb");
+    my_assert(file != NULL);
+    fseek(file, 8, SEEK_SET);
+    my_assert(fread(&count, sizeof(count), 1, file) == 1 && fread(&dataOffset, sizeof(dataOffset), 1, file) == 1);
+    fclose(file);
+    my_assert(count == 4);
+
+    // Padding is zeroed rather than copied from the stack
+    unsigned char image[4 * sizeof(Node)];
+    file = fopen(path, "rb");
+    fseek(file, (long)dataOffset, SEEK_SET);
+    my_assert(fread(image, 1, sizeof(image), file) == sizeof(image));
+    fclose(file);
+    for (size_t i = 0; i < 4; i++)
+    {
+        for (size_t b = sizeof(uint16_t); b < offsetof(Node, next); b++)
+            my_assert(image[i * sizeof(Node) + b] == 0);
+    }
+
+    // A count whose node image overflows or exceeds the pool
+    uint64_t huge = UINT64_MAX / 4;
+    patch_file(path, 8, &huge, sizeof(huge));
+    my_assert(list_load(&loaded, path) == -1 && loaded == NULL);
+    patch_file(path, 8, &count, sizeof(count));
+
+    // A link from the last node back to the second makes a cycle
+    uintptr_t link = sizeof(Node) + 1;
+    patch_file(path, (long)dataOffset + 3 * sizeof(Node) + offsetof(Node, next), &link, sizeof(link));
+    my_assert(list_load(&loaded, path) == -1 && loaded == NULL);
+    mem_deinit();
+
+    // Two links to the same node leave another unreachable
+    link = 3 * sizeof(Node) + 1;
+    patch_file(path, (long)dataOffset + 0 * sizeof(Node) + offsetof(Node, next), &link, sizeof(link));
+    link = 0;
+    patch_file(path, (long)dataOffset + 3 * sizeof(Node) + offsetof(Node, next), &link, sizeof(link));
+    my_assert(list_load(&loaded, path) == -1 && loaded == NULL);
+    mem_deinit();
+
+    // A link beyond the image
+    link = 4 * sizeof(Node) + 1;
+    patch_file(path, (long)dataOffset + offsetof(Node, next), &link, sizeof(link));
+    my_assert(list_load(&loaded, path) == -1 && loaded == NULL);
+    mem_deinit();
+
+    // A file shorter than the pool it claims
+    my_assert(truncate(path, (off_t)dataOffset + sizeof(Node)) == 0);
+    my_assert(list_load(&loaded, path) == -1 && loaded == NULL);
+
+    remove(path);
+    printf_green("[PASS].\n");
+}
+
+// ********* Concurrency *********
+
+typedef struct
+{
+    Node **head;
+    int iterations;
+    int found;
+} ReaderArgs;
+
+// Search for the values that are never deleted while a writer churns the list
+static void *search_worker(void *arg)
+{
+    ReaderArgs *args = arg;
+    for (int i = 0; i < args->iterations; i++)
+    {
+        Node *node = list_search(args->head, i % 100);
+        if (node != NULL && node->data == i % 100)
+        {
+            args->found++;
+        }
+    }
+    return NULL;
+}
+
+void test_list_concurrent_readers()
+{
+    printf_yellow("  Testing concurrent readers and a writer ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 200);
+    for (int i = 0; i < 100; i++)
+    {
+        list_insert(&head, i);
+    }
+
+    pthread_t readers[4];
+    ReaderArgs args[4];
+    for (int t = 0; t < 4; t++)
+    {
+        args[t].head = &head;
+        args[t].iterations = 20000;
+        args[t].found = 0;
+        pthread_create(&readers[t], NULL, search_worker, &args[t]);
+    }
+
+    for (int i = 0; i < 2000; i++)
+    {
+        list_insert(&head, 1000 + i % 50);
+        list_delete(&head, 1000 + i % 50);
+    }
+
+    for (int t = 0; t < 4; t++)
+    {
+        pthread_join(readers[t], NULL);
+        my_assert(args[t].found == args[t].iterations);
+    }
+    my_assert(list_count_nodes(&head) == 100);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+// Visitor for test_list_foreach: sums values and stops at ctx->stopAt
+typedef struct
+{
+    unsigned long sum;
+    int stopAt;
+} SumArgs;
+
+static int sum_visit(uint16_t data, void *ctx)
+{
+    SumArgs *args = ctx;
+    args->sum += data;
+    return data == args->stopAt;
+}
+
+void test_list_foreach()
+{
+    printf_yellow("  Testing list_foreach ---> ");
+    Node *head = NULL;
+    list_init(&head, 100);
+
+    SumArgs args = {0, -1};
+    my_assert(list_foreach(&head, sum_visit, &args) == 0);
+    for (int i = 1; i <= 100; i++)
+    {
+        list_insert(&head, i);
+    }
+
+    my_assert(list_foreach(&head, sum_visit, &args) == 100);
+    my_assert(args.sum == 5050);
+
+    // Returning nonzero stops the walk
+    args = (SumArgs){0, 10};
+    my_assert(list_foreach(&head, sum_visit, &args) == 10);
+    my_assert(args.sum == 55);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_cursor_batch()
+{
+    printf_yellow("  Testing list_cursor_next_batch ---> ");
+    Node *head = NULL;
+    list_init(&head, 100);
+    for (int i = 0; i < 100; i++)
+    {
+        list_insert(&head, i);
+    }
+
+    ListCursor cursor;
+    list_cursor_init(&cursor, &head);
+    uint16_t batch[32];
+    int expected = 0;
+    size_t n;
+    while ((n = list_cursor_next_batch(&cursor, batch, 32)) > 0)
+    {
+        my_assert(n == 32 || expected + n == 100);
+        for (size_t i = 0; i < n; i++)
+        {
+            my_assert(batch[i] == expected);
+            expected++;
+        }
+    }
+    my_assert(expected == 100);
+    my_assert(list_cursor_next_batch(&cursor, batch, 32) == 0); // Stays at the end
+
+    // A cursor on an empty list returns nothing
+    Node *empty = NULL;
+    list_cursor_init(&cursor, &empty);
+    my_assert(list_cursor_next_batch(&cursor, batch, 32) == 0);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_parallel_reduce()
+{
+    printf_yellow("  Testing list_parallel_reduce ---> ");
+    Node *head = NULL;
+    list_init(&head, 10000);
+
+    ListReduction result;
+    my_assert(list_parallel_reduce(&head, 4, 0, 65535, &result) == 0);
+    my_assert(result.count == 0 && result.sum == 0 && result.min == 0 && result.max == 0);
+
+    // Reference values computed while inserting
+    ListReduction expected;
+    memset(&expected, 0, sizeof(expected));
+    expected.min = UINT16_MAX;
+    for (int i = 0; i < 10000; i++)
+    {
+        uint16_t value = rand() % 65536;
+        list_insert(&head, value);
+        expected.count++;
+        expected.sum += value;
+        if (value < expected.min)
+            expected.min = value;
+        if (value > expected.max)
+            expected.max = value;
+        if (value >= 1000 && value <= 20000)
+            expected.matches++;
+        expected.histogram[value >> 8]++;
+    }
+    // Free some nodes in the middle of the pool so blocks and list order differ
+    for (int i = 0; i < 100; i++)
+    {
+        uint16_t value = head->next->data;
+        list_delete(&head, value);
+        list_insert(&head, value);
+    }
+
+    for (int nThreads = 1; nThreads <= LIST_MAX_WORKERS; nThreads *= 2)
+    {
+        my_assert(list_parallel_reduce(&head, nThreads, 1000, 20000, &result) == 0);
+        my_assert(result.count == expected.count);
+        my_assert(result.sum == expected.sum);
+        my_assert(result.min == expected.min && result.max == expected.max);
+        my_assert(result.matches == expected.matches);
+        my_assert(memcmp(result.histogram, expected.histogram, sizeof(result.histogram)) == 0);
+    }
+
+    // A block that is not a node makes it walk the list instead
+    list_cleanup(&head);
+    list_init(&head, 100);
+    void *stray = mem_alloc(sizeof(Node));
+    list_insert(&head, 7);
+    list_insert(&head, 9);
+    my_assert(list_parallel_reduce(&head, 2, 0, 8, &result) == 0);
+    my_assert(result.count == 2 && result.sum == 16 && result.matches == 1);
+    mem_free(stray);
+
+    list_parallel_shutdown();
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_pool_scan()
+{
+    printf_yellow("  Testing list_pool_scan ---> ");
+    Node *head = NULL;
+    list_init(&head, 1000);
+
+    SumArgs args = {0, -1};
+    my_assert(list_pool_scan(&head, sum_visit, &args) == 0);
+    my_assert(!list_contains(&head, 0));
+
+    for (int i = 1; i <= 1000; i++)
+    {
+        list_insert(&head, i);
+    }
+    // Move nodes around so pool order and list order differ
+    for (int i = 0; i < 100; i++)
+    {
+        uint16_t value = head->next->data;
+        list_delete(&head, value);
+        list_insert(&head, value);
+    }
+
+    my_assert(list_pool_scan(&head, sum_visit, &args) == 1000);
+    my_assert(args.sum == 500500);
+    my_assert(list_contains(&head, 1) && list_contains(&head, 500) && list_contains(&head, 1000));
+    my_assert(!list_contains(&head, 1001));
+
+    // A block that is not a node makes it walk the list instead
+    list_cleanup(&head);
+    list_init(&head, 100);
+    void *stray = mem_alloc(sizeof(Node));
+    list_insert(&head, 7);
+    list_insert(&head, 9);
+    args = (SumArgs){0, -1};
+    my_assert(list_pool_scan(&head, sum_visit, &args) == 2);
+    my_assert(args.sum == 16);
+    my_assert(list_contains(&head, 9) && !list_contains(&head, 8));
+    mem_free(stray);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_relayout()
+{
+    printf_yellow("  Testing list_relayout ---> ");
+    Node *head = NULL;
+    list_init(&head, 1000);
+
+    my_assert(list_relayout(&head) == 0);
+    my_assert(list_disorder(&head) == 0.0);
+
+    for (int i = 0; i < 500; i++)
+    {
+        list_insert(&head, i);
+    }
+    my_assert(list_disorder(&head) == 0.0);
+
+    // Delete and insert in the middle so consecutive nodes end up scattered
+    for (int i = 0; i < 500; i++)
+    {
+        Node *node = head;
+        for (int k = rand() % 400; k > 0; k--)
+        {
+            node = node->next;
+        }
+        list_insert_after(node, 1000 + i);
+
+        // Values are unique, so this deletes the node picked at random
+        node = head;
+        for (int k = rand() % 400; k > 0; k--)
+        {
+            node = node->next;
+        }
+        list_delete(&head, node->data);
+    }
+    my_assert(list_disorder(&head) > 0.1);
+
+    char before[8192];
+    char after[8192];
+    list_to_buffer(&head, before, sizeof(before));
+    int count = list_count_nodes(&head);
+
+    my_assert(list_relayout(&head) == 0);
+    my_assert(list_disorder(&head) == 0.0);
+    list_to_buffer(&head, after, sizeof(after));
+    my_assert(strcmp(before, after) == 0);
+    my_assert(list_count_nodes(&head) == count);
+    for (Node *node = head; node->next != NULL; node = node->next)
+    {
+        my_assert(node->next > node);
+    }
+
+    // A block that is not a node makes it sort the node addresses instead
+    list_cleanup(&head);
+    list_init(&head, 100);
+    void *stray = mem_alloc(sizeof(Node));
+    list_insert(&head, 1);
+    list_insert(&head, 4);
+    list_insert_after(head, 2);
+    list_insert_after(head->next, 3);
+    my_assert(list_disorder(&head) > 0.0);
+    my_assert(list_relayout(&head) == 0);
+    my_assert(list_disorder(&head) == 0.0);
+    list_to_buffer(&head, after, sizeof(after));
+    my_assert(strcmp(after, "[1, 2, 3, 4]") == 0);
+    mem_free(stray);
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+// Two lists sharing one pool must not see each other's nodes
+void test_list_shared_pool()
+{
+    printf_yellow("  Testing two lists in one pool ---> ");
+    Node *a = NULL;
+    Node *b = NULL;
+    list_init(&a, 16);
+    list_insert(&a, 1);
+    list_insert(&a, 2);
+    list_insert(&a, 3);
+    my_assert(list_count_nodes(&a) == 3);
+    list_insert(&b, 7);
+    list_insert(&b, 9);
+
+    my_assert(list_count_nodes(&a) == 3);
+    my_assert(list_count_nodes(&b) == 2);
+
+    ListReduction r;
+    my_assert(list_parallel_reduce(&a, 2, 0, UINT16_MAX, &r) == 0);
+    my_assert(r.count == 3 && r.sum == 6 && r.max == 3);
+    my_assert(list_parallel_reduce(&b, 2, 0, UINT16_MAX, &r) == 0);
+    my_assert(r.count == 2 && r.sum == 16 && r.min == 7);
+
+    // Scans visit only the caller's list
+    my_assert(list_contains(&a, 3) == 1);
+    my_assert(list_contains(&a, 9) == 0);
+    my_assert(list_contains(&b, 1) == 0);
+    SumArgs args = {0, -1};
+    my_assert(list_pool_scan(&a, sum_visit, &args) == 3);
+    my_assert(args.sum == 6);
+
+    list_insert_after(b, 8);
+    list_delete(&a, 2);
+    my_assert(list_count_nodes(&a) == 2);
+    my_assert(list_count_nodes(&b) == 3);
+
+    // A copy of a head pointer is the same list
+    Node *copy = b;
+    my_assert(list_count_nodes(&copy) == 3);
+
+    // Merged lists keep one length, the emptied one has none
+    list_sort(&b);
+    list_merge_sorted(&a, &b);
+    my_assert(list_count_nodes(&a) == 5 && list_count_nodes(&b) == 0);
+    list_insert(&b, 4);
+    list_delete(&a, 1);
+    my_assert(list_count_nodes(&a) == 4 && list_count_nodes(&b) == 1);
+
+    list_cleanup(&b);
+    my_assert(list_count_nodes(&b) == 0);
+    my_assert(list_count_nodes(&a) == 4);
+    list_cleanup(&a);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
 // Main function to run all tests
 int main(int argc, char *argv[])
 {
@@ -499,6 +1163,32 @@ int main(int argc, char *argv[])
         printf(" 12. test_list_delete_loop - Test multiple detelions\n");
         printf(" 13. test_list_search_loop - Test multiple search\n");
         printf(" 14. test_list_edge_cases - Test edge cases\n");
+
+        printf("\nSorted Operations:\n");
+        printf(" 15. test_list_insert_sorted - Test ordered insertion\n");
+        printf(" 16. test_list_sort - Test in-place merge sort\n");
+        printf(" 17. test_list_merge_sorted - Test merging two sorted lists\n");
+
+        printf("\nSerialization:\n");
+        printf(" 18. test_list_to_buffer - Test formatting into a caller buffer\n");
+        printf(" 19. test_list_write_fd - Test writing a large list to a file descriptor\n");
+        printf(" 20. test_list_save_load - Test saving a list and mapping it back in\n");
+        printf(" 28. test_list_load_corrupt - Test rejecting damaged snapshots\n");
+
+        printf("\nConcurrency:\n");
+        printf(" 21. test_list_concurrent_readers - Test searches running alongside inserts and deletes\n");
+
+        printf("\nTraversal:\n");
+        printf(" 22. test_list_foreach - Test visiting every element under one lock\n");
+        printf(" 23. test_list_cursor_batch - Test copying elements out in batches\n");
+        printf(" 24. test_list_parallel_reduce - Test aggregates computed on 1 to 16 threads\n");
+        printf(" 25. test_list_pool_scan - Test order-insensitive queries in pool order\n");
+
+        printf("\nLayout:\n");
+        printf(" 26. test_list_relayout - Test rebuilding list order to match address order\n");
+
+        printf("\nShared pool:\n");
+        printf(" 27. test_list_shared_pool - Test two lists allocating from one pool\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -526,6 +1216,32 @@ int main(int argc, char *argv[])
         test_list_delete_loop(1000);
         test_list_search_loop(1000);
         test_list_edge_cases();
+
+        printf("\nTesting Sorted Operations:\n");
+        test_list_insert_sorted();
+        test_list_sort(1000);
+        test_list_merge_sorted();
+
+        printf("\nTesting Serialization:\n");
+        test_list_to_buffer();
+        test_list_write_fd(20000);
+        test_list_save_load(1000);
+        test_list_load_corrupt();
+
+        printf("\nTesting Concurrency:\n");
+        test_list_concurrent_readers();
+
+        printf("\nTesting Traversal:\n");
+        test_list_foreach();
+        test_list_cursor_batch();
+        test_list_parallel_reduce();
+        test_list_pool_scan();
+
+        printf("\nTesting Layout:\n");
+        test_list_relayout();
+
+        printf("\nTesting Shared Pool:\n");
+        test_list_shared_pool();
         break;
     case 1:
         test_list_init();
@@ -570,6 +1286,48 @@ int main(int argc, char *argv[])
     case 14:
         test_list_edge_cases();
         break;
+    case 15:
+        test_list_insert_sorted();
+        break;
+    case 16:
+        test_list_sort(1000);
+        break;
+    case 17:
+        test_list_merge_sorted();
+        break;
+    case 18:
+        test_list_to_buffer();
+        break;
+    case 19:
+        test_list_write_fd(20000);
+        break;
+    case 20:
+        test_list_save_load(1000);
+        break;
+    case 21:
+        test_list_concurrent_readers();
+        break;
+    case 22:
+        test_list_foreach();
+        break;
+    case 23:
+        test_list_cursor_batch();
+        break;
+    case 24:
+        test_list_parallel_reduce();
+        break;
+    case 25:
+        test_list_pool_scan();
+        break;
+    case 26:
+        test_list_relayout();
+        break;
+    case 27:
+        test_list_shared_pool();
+        break;
+    case 28:
+        test_list_load_corrupt();
+        break;
 
     default:
         printf("Invalid test function\n");
@@ -0,0 +1,284 @@
+#include "memory_manager.h"
+#include "lockfree.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+#define MPMC_THREADS 4    // Producers, and as many consumers
+#define MPMC_ITEMS 20000  // Values pushed by each producer
+
+// ********* Test basic container operations *********
+
+void test_ring_buffer()
+{
+    printf_yellow("  Testing ring_push and ring_pop ---> ");
+    mem_init(1024);
+    RingBuffer ring;
+    my_assert(ring_init(&ring, 3) == 0); // Rounded up to 4
+
+    uint16_t value;
+    my_assert(ring_pop(&ring, &value) == -1);
+    for (int i = 0; i < 4; i++)
+    {
+        my_assert(ring_push(&ring, 10 + i) == 0);
+    }
+    my_assert(ring_push(&ring, 99) == -1); // Full
+
+    for (int round = 0; round < 10; round++)
+    {
+        // Wrap around the array several times, staying first in first out
+        my_assert(ring_pop(&ring, &value) == 0);
+        my_assert(value == 10 + round);
+        my_assert(ring_push(&ring, 14 + round) == 0);
+    }
+
+    ring_cleanup(&ring);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_lfstack()
+{
+    printf_yellow("  Testing lfstack_push and lfstack_pop ---> ");
+    mem_init(1024);
+    LfStack stack;
+    lfstack_init(&stack);
+
+    uint16_t value;
+    my_assert(lfstack_pop(&stack, &value) == -1);
+    lfstack_push(&stack, 10);
+    lfstack_push(&stack, 20);
+    lfstack_push(&stack, 30);
+    my_assert(lfstack_pop(&stack, &value) == 0 && value == 30);
+    my_assert(lfstack_pop(&stack, &value) == 0 && value == 20);
+    lfstack_push(&stack, 40);
+    my_assert(lfstack_pop(&stack, &value) == 0 && value == 40);
+
+    lfstack_cleanup(&stack); // Frees the 10 still on the stack
+    void *all = mem_alloc(1024);
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_lfqueue()
+{
+    printf_yellow("  Testing lfqueue_enqueue and lfqueue_dequeue ---> ");
+    mem_init(1024);
+    LfQueue queue;
+    my_assert(lfqueue_init(&queue) == 0);
+
+    uint16_t value;
+    my_assert(lfqueue_dequeue(&queue, &value) == -1);
+    lfqueue_enqueue(&queue, 10);
+    lfqueue_enqueue(&queue, 20);
+    my_assert(lfqueue_dequeue(&queue, &value) == 0 && value == 10);
+    lfqueue_enqueue(&queue, 30);
+    my_assert(lfqueue_dequeue(&queue, &value) == 0 && value == 20);
+    my_assert(lfqueue_dequeue(&queue, &value) == 0 && value == 30);
+    my_assert(lfqueue_dequeue(&queue, &value) == -1);
+    lfqueue_enqueue(&queue, 40);
+
+    lfqueue_cleanup(&queue);
+    void *all = mem_alloc(1024);
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// ********* Concurrency *********
+
+enum
+{
+    MPMC_RING,
+    MPMC_STACK,
+    MPMC_QUEUE
+};
+
+typedef struct
+{
+    int kind;
+    RingBuffer *ring;
+    LfStack *stack;
+    LfQueue *queue;
+    size_t *consumed;       // Values taken so far by all consumers
+    unsigned long long sum; // Sum of the values this consumer took
+} MpmcArgs;
+
+static int mpmc_push(MpmcArgs *args, uint16_t value)
+{
+    switch (args->kind)
+    {
+    case MPMC_RING:
+        return ring_push(args->ring, value);
+    case MPMC_STACK:
+        return lfstack_push(args->stack, value);
+    default:
+        return lfqueue_enqueue(args->queue, value);
+    }
+}
+
+static int mpmc_pop(MpmcArgs *args, uint16_t *value)
+{
+    switch (args->kind)
+    {
+    case MPMC_RING:
+        return ring_pop(args->ring, value);
+    case MPMC_STACK:
+        return lfstack_pop(args->stack, value);
+    default:
+        return lfqueue_dequeue(args->queue, value);
+    }
+}
+
+static void *mpmc_producer(void *arg)
+{
+    MpmcArgs *args = arg;
+    for (int i = 1; i <= MPMC_ITEMS; i++)
+    {
+        while (mpmc_push(args, i) != 0)
+        {
+            sched_yield(); // Full
+        }
+    }
+    return NULL;
+}
+
+static void *mpmc_consumer(void *arg)
+{
+    MpmcArgs *args = arg;
+    size_t total = (size_t)MPMC_THREADS * MPMC_ITEMS;
+    while (__atomic_load_n(args->consumed, __ATOMIC_RELAXED) < total)
+    {
+        uint16_t value;
+        if (mpmc_pop(args, &value) == 0)
+        {
+            args->sum += value;
+            __atomic_add_fetch(args->consumed, 1, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void test_mpmc(int kind, const char *name)
+{
+    printf_yellow("  Testing %s with %d producers and %d consumers ---> ", name, MPMC_THREADS, MPMC_THREADS);
+    mem_init(1024 * 1024);
+    RingBuffer ring;
+    LfStack stack;
+    LfQueue queue;
+    my_assert(ring_init(&ring, 1024) == 0);
+    lfstack_init(&stack);
+    my_assert(lfqueue_init(&queue) == 0);
+
+    size_t consumed = 0;
+    pthread_t producers[MPMC_THREADS], consumers[MPMC_THREADS];
+    MpmcArgs args[MPMC_THREADS];
+    for (int i = 0; i < MPMC_THREADS; i++)
+    {
+        args[i] = (MpmcArgs){kind, &ring, &stack, &queue, &consumed, 0};
+        pthread_create(&consumers[i], NULL, mpmc_consumer, &args[i]);
+        pthread_create(&producers[i], NULL, mpmc_producer, &args[i]);
+    }
+
+    unsigned long long sum = 0;
+    for (int i = 0; i < MPMC_THREADS; i++)
+    {
+        pthread_join(producers[i], NULL);
+        pthread_join(consumers[i], NULL);
+        sum += args[i].sum;
+    }
+
+    // Every value arrived exactly once
+    my_assert(consumed == (size_t)MPMC_THREADS * MPMC_ITEMS);
+    my_assert(sum == (unsigned long long)MPMC_THREADS * MPMC_ITEMS * (MPMC_ITEMS + 1) / 2);
+
+    ring_cleanup(&ring);
+    lfstack_cleanup(&stack);
+    lfqueue_cleanup(&queue);
+    void *all = mem_alloc(1024 * 1024); // Retired nodes all went back to the pool
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_ring_buffer - Test the bounded ring buffer\n");
+        printf(" 2. test_lfstack - Test the lock-free stack\n");
+        printf(" 3. test_lfqueue - Test the lock-free queue\n");
+
+        printf("\nConcurrency:\n");
+        printf(" 4. test_mpmc ring - Many producers and consumers on the ring buffer\n");
+        printf(" 5. test_mpmc stack - Many producers and consumers on the stack\n");
+        printf(" 6. test_mpmc queue - Many producers and consumers on the queue\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_ring_buffer();
+        test_lfstack();
+        test_lfqueue();
+
+        printf("\nTesting Concurrency:\n");
+        test_mpmc(MPMC_RING, "ring buffer");
+        test_mpmc(MPMC_STACK, "lfstack");
+        test_mpmc(MPMC_QUEUE, "lfqueue");
+        break;
+    case 1:
+        test_ring_buffer();
+        break;
+    case 2:
+        test_lfstack();
+        break;
+    case 3:
+        test_lfqueue();
+        break;
+    case 4:
+        test_mpmc(MPMC_RING, "ring buffer");
+        break;
+    case 5:
+        test_mpmc(MPMC_STACK, "lfstack");
+        break;
+    case 6:
+        test_mpmc(MPMC_QUEUE, "lfqueue");
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "memory_manager.h"
+#include "lru_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// ********* Test basic cache operations *********
+
+void test_lru_put_get()
+{
+    printf_yellow("  Testing lru_put and lru_get ---> ");
+    LruCache cache;
+    my_assert(lru_init(&cache, 4) == 0);
+
+    uint32_t value;
+    my_assert(lru_get(&cache, 1, &value) == -1);
+    lru_put(&cache, 1, 100);
+    lru_put(&cache, 2, 200);
+    my_assert(lru_get(&cache, 1, &value) == 0 && value == 100);
+    my_assert(lru_get(&cache, 2, &value) == 0 && value == 200);
+
+    lru_put(&cache, 1, 111); // Update in place
+    my_assert(lru_get(&cache, 1, &value) == 0 && value == 111);
+    my_assert(lru_count(&cache) == 2);
+
+    LruStats stats;
+    lru_stats(&cache, &stats);
+    my_assert(stats.hits == 3 && stats.misses == 1 && stats.evictions == 0);
+
+    lru_cleanup(&cache);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_lru_eviction()
+{
+    printf_yellow("  Testing least recently used eviction ---> ");
+    LruCache cache;
+    my_assert(lru_init(&cache, 3) == 0);
+
+    uint32_t value;
+    lru_put(&cache, 1, 10);
+    lru_put(&cache, 2, 20);
+    lru_put(&cache, 3, 30);
+    my_assert(lru_get(&cache, 1, &value) == 0); // 2 is now the oldest
+
+    lru_put(&cache, 4, 40);
+    my_assert(lru_get(&cache, 2, &value) == -1);
+    my_assert(lru_get(&cache, 1, &value) == 0 && value == 10);
+    my_assert(lru_get(&cache, 3, &value) == 0 && value == 30);
+    my_assert(lru_get(&cache, 4, &value) == 0 && value == 40);
+
+    lru_put(&cache, 5, 50); // 1 is the oldest now
+    my_assert(lru_get(&cache, 1, &value) == -1);
+    my_assert(lru_count(&cache) == 3);
+
+    LruStats stats;
+    lru_stats(&cache, &stats);
+    my_assert(stats.evictions == 2);
+
+    lru_cleanup(&cache);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_lru_remove()
+{
+    printf_yellow("  Testing lru_remove ---> ");
+    LruCache cache;
+    my_assert(lru_init(&cache, 2) == 0);
+
+    uint32_t value;
+    lru_put(&cache, 1, 10);
+    lru_put(&cache, 2, 20);
+    my_assert(lru_remove(&cache, 1) == 0);
+    my_assert(lru_remove(&cache, 1) == -1);
+    my_assert(lru_count(&cache) == 1);
+
+    // The freed slot is used before anything is evicted
+    lru_put(&cache, 3, 30);
+    my_assert(lru_get(&cache, 2, &value) == 0 && value == 20);
+    my_assert(lru_get(&cache, 3, &value) == 0 && value == 30);
+
+    lru_cleanup(&cache);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_lru_against_reference(int capacity, int keys, int steps)
+{
+    printf_yellow("  Testing against a reference model (%d entries, %d keys) ---> ", capacity, keys);
+    LruCache cache;
+    my_assert(lru_init(&cache, capacity) == 0);
+
+    // Reference: the time each key was last used, 0 when absent
+    unsigned long *lastUse = calloc(keys, sizeof(unsigned long));
+    uint32_t *values = calloc(keys, sizeof(uint32_t));
+    int present = 0;
+
+    srand(42);
+    for (int step = 1; step <= steps; step++)
+    {
+        uint32_t key = rand() % keys;
+        uint32_t value;
+        int hit = lru_get(&cache, key, &value) == 0;
+        my_assert(hit == (lastUse[key] != 0));
+        if (hit)
+        {
+            my_assert(value == values[key]);
+            lastUse[key] = step;
+            continue;
+        }
+
+        if (present == capacity)
+        {
+            // Evict the key with the oldest use
+            int oldest = -1;
+            for (int k = 0; k < keys; k++)
+            {
+                if (lastUse[k] != 0 && (oldest < 0 || lastUse[k] < lastUse[oldest]))
+                {
+                    oldest = k;
+                }
+            }
+            lastUse[oldest] = 0;
+            present--;
+        }
+        values[key] = rand();
+        lru_put(&cache, key, values[key]);
+        lastUse[key] = step;
+        present++;
+    }
+    my_assert(lru_count(&cache) == (size_t)present);
+
+    free(lastUse);
+    free(values);
+    lru_cleanup(&cache);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_lru_put_get - Test put, get and update\n");
+        printf(" 2. test_lru_eviction - Test that the least recently used entry is evicted\n");
+        printf(" 3. test_lru_remove - Test removing entries\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 4. test_lru_against_reference - Compare random traffic with a reference model\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_lru_put_get();
+        test_lru_eviction();
+        test_lru_remove();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_lru_against_reference(64, 200, 100000);
+        break;
+    case 1:
+        test_lru_put_get();
+        break;
+    case 2:
+        test_lru_eviction();
+        break;
+    case 3:
+        test_lru_remove();
+        break;
+    case 4:
+        test_lru_against_reference(64, 200, 100000);
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
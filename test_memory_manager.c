@@ -1,9 +1,17 @@
+#define _GNU_SOURCE  // For the CPU affinity calls of test_numa_pool
 #include "memory_manager.h"
+#include "epoch.h"
+#include "mem_profile.h"
+#include "mem_trace.h"
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <sched.h>
 #include "common_defs.h"
 
 #include "gitdata.h"
@@ -326,6 +334,962 @@ void test_edge_case_allocations()
     printf_green("[PASS].\n");
 }
 
+void test_handle_lock_unlock()
+{
+    printf_yellow("  Testing mem_handle_lock and mem_handle_unlock ---> ");
+    mem_init(1024);
+
+    mem_handle_t handle = mem_handle_alloc(100);
+    my_assert(handle != MEM_INVALID_HANDLE);
+
+    char *data = mem_handle_lock(handle);
+    my_assert(data != NULL);
+    memset(data, 'a', 100);
+    mem_handle_unlock(handle);
+
+    data = mem_handle_lock(handle);
+    my_assert(data[0] == 'a' && data[99] == 'a');
+    mem_handle_unlock(handle);
+
+    mem_handle_free(handle);
+    void *block = mem_alloc(1024); // Freeing the handle should return the whole pool
+    my_assert(block != NULL);
+
+    mem_free(block);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_compaction()
+{
+    printf_yellow("  Testing mem_compact ---> ");
+    mem_init(1024);
+
+    // Fragment the pool: every other 128 byte block is freed
+    mem_handle_t handles[8];
+    for (int i = 0; i < 8; i++)
+    {
+        handles[i] = mem_handle_alloc(128);
+        my_assert(handles[i] != MEM_INVALID_HANDLE);
+        memset(mem_handle_lock(handles[i]), i, 128);
+        mem_handle_unlock(handles[i]);
+    }
+    for (int i = 0; i < 8; i += 2)
+    {
+        mem_handle_free(handles[i]);
+    }
+
+    void *block = mem_alloc(512); // Enough free bytes, but not contiguous
+    my_assert(block == NULL);
+
+    MemCompactStats stats;
+    mem_compact(&stats);
+    my_assert(stats.blocks_moved == 4);
+    my_assert(stats.bytes_moved == 4 * 128);
+    my_assert(stats.largest_free_block == 512);
+
+    // Moved blocks must keep their contents
+    for (int i = 1; i < 8; i += 2)
+    {
+        unsigned char *data = mem_handle_lock(handles[i]);
+        my_assert(data[0] == i && data[127] == i);
+        mem_handle_unlock(handles[i]);
+    }
+
+    block = mem_alloc(512);
+    my_assert(block != NULL);
+
+    mem_free(block);
+    for (int i = 1; i < 8; i += 2)
+    {
+        mem_handle_free(handles[i]);
+    }
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_compaction_pinned()
+{
+    printf_yellow("  Testing mem_compact with pinned blocks ---> ");
+    mem_init(1024);
+
+    mem_handle_t first = mem_handle_alloc(200);
+    void *pinned = mem_alloc(200);              // Plain allocations never move
+    mem_handle_t locked = mem_handle_alloc(200);
+    mem_handle_free(first);
+
+    char *data = mem_handle_lock(locked);
+    MemCompactStats stats;
+    mem_compact(&stats);
+    my_assert(stats.blocks_moved == 0);
+    my_assert(mem_handle_lock(locked) == data); // Locked handles stay put
+    mem_handle_unlock(locked);
+    mem_handle_unlock(locked);
+
+    mem_free(pinned);
+    mem_compact(&stats);
+    my_assert(stats.blocks_moved == 1);
+    my_assert(stats.largest_free_block == 1024 - 200);
+
+    mem_handle_free(locked);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_alloc_batch()
+{
+    printf_yellow("  Testing mem_alloc_batch ---> ");
+    mem_init(1024);
+
+    char *blocks = mem_alloc_batch(10, 16);
+    my_assert(blocks != NULL);
+    void *next = mem_alloc(100);
+    my_assert(next == blocks + 160); // The batch is contiguous
+
+    // Each block of the batch is freed on its own
+    mem_free(blocks + 16);
+    void *reused = mem_alloc(16);
+    my_assert(reused == blocks + 16);
+
+    my_assert(mem_alloc_batch(100, 16) == NULL); // Does not fit
+
+    for (int i = 0; i < 10; i++)
+    {
+        mem_free(blocks + i * 16);
+    }
+    mem_free(next);
+    void *all = mem_alloc(1024);
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_shared_pool()
+{
+    printf_yellow("  Testing mem_init_shared across processes ---> ");
+    const char *name = "/test_memory_manager_shared";
+    const int nBlocks = 100;
+    mem_unlink_shared(name); // Remove a segment left over from an aborted run
+    my_assert(mem_init_shared(name, 64 * 1024) == 0);
+
+    // The child reports its block offsets through a shared root block
+    size_t *childOffsets = mem_alloc(sizeof(size_t) * nBlocks);
+    my_assert(childOffsets != NULL);
+    size_t rootOffset = (char *)childOffsets - (char *)mem_pool_base();
+
+    fflush(stdout);
+    pid_t pid = fork();
+    my_assert(pid >= 0);
+    if (pid == 0)
+    {
+        mem_deinit(); // Drop the inherited mapping and attach by name
+        if (mem_init_shared(name, 0) != 0)
+        {
+            _exit(1);
+        }
+        size_t *offsets = (size_t *)((char *)mem_pool_base() + rootOffset);
+        for (int i = 0; i < nBlocks; i++)
+        {
+            char *block = mem_alloc(64);
+            if (block == NULL)
+            {
+                _exit(1);
+            }
+            memset(block, 'c', 64);
+            offsets[i] = block - (char *)mem_pool_base();
+        }
+        mem_deinit();
+        _exit(0);
+    }
+
+    char *blocks[nBlocks];
+    for (int i = 0; i < nBlocks; i++)
+    {
+        blocks[i] = mem_alloc(64);
+        my_assert(blocks[i] != NULL);
+        memset(blocks[i], 'p', 64);
+    }
+
+    int status;
+    my_assert(waitpid(pid, &status, 0) == pid);
+    my_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // Both processes allocated from one pool without handing out a block twice
+    for (int i = 0; i < nBlocks; i++)
+    {
+        char *childBlock = (char *)mem_pool_base() + childOffsets[i];
+        my_assert(childBlock[0] == 'c' && childBlock[63] == 'c');
+        my_assert(blocks[i][0] == 'p' && blocks[i][63] == 'p');
+    }
+
+    for (int i = 0; i < nBlocks; i++)
+    {
+        mem_free(blocks[i]);
+        mem_free((char *)mem_pool_base() + childOffsets[i]);
+    }
+    mem_free(childOffsets);
+    mem_deinit();
+    mem_unlink_shared(name);
+    printf_green("[PASS].\n");
+}
+
+void test_free_batch()
+{
+    printf_yellow("  Testing mem_free_batch ---> ");
+    mem_init(1024);
+
+    void *blocks[8];
+    for (int i = 0; i < 8; i++)
+    {
+        blocks[i] = mem_alloc(128);
+        my_assert(blocks[i] != NULL);
+    }
+
+    // Free out of order, with neighbours that merge both ways
+    void *batch[] = {blocks[5], blocks[1], blocks[2], blocks[7], blocks[0], blocks[6]};
+    mem_free_batch(batch, 6);
+    void *two = mem_alloc(2 * 128); // Blocks 0..2 merged, first fit from the start
+    my_assert(two == blocks[0]);
+    void *big = mem_alloc(3 * 128); // Blocks 5..7 merged into one
+    my_assert(big == blocks[5]);
+
+    // A pointer listed twice is freed once, its neighbours stay allocated
+    void *twice[] = {blocks[4], blocks[3], blocks[4]};
+    mem_free_batch(twice, 3);
+    void *middle = mem_alloc(3 * 128); // Blocks 2..4, between two and big
+    my_assert(middle == blocks[2]);
+    my_assert(mem_alloc(1) == NULL);
+
+    mem_free(middle);
+    mem_free(big);
+    mem_free(two);
+
+    void *all = mem_alloc(1024);
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Reader for test_epoch_deferred_free: stays inside an epoch until released
+typedef struct
+{
+    volatile int entered;
+    volatile int release;
+} EpochReader;
+
+static void *epoch_reader(void *arg)
+{
+    EpochReader *reader = arg;
+    epoch_enter();
+    reader->entered = 1;
+    while (!reader->release)
+    {
+        sched_yield();
+    }
+    epoch_exit();
+    return NULL;
+}
+
+void test_epoch_deferred_free()
+{
+    printf_yellow("  Testing mem_retire waits for readers ---> ");
+    mem_init(1024);
+
+    void *block = mem_alloc(64);
+    void *rest = mem_alloc(1024 - 64); // Fill the pool so reuse is visible
+    my_assert(block != NULL && rest != NULL);
+
+    EpochReader reader = {0, 0};
+    pthread_t thread;
+    pthread_create(&thread, NULL, epoch_reader, &reader);
+    while (!reader.entered)
+    {
+        sched_yield();
+    }
+
+    // The reader may still hold the block, so it must not come back yet
+    mem_retire(block);
+    for (int i = 0; i < 10; i++)
+    {
+        epoch_reclaim();
+    }
+    my_assert(mem_alloc(64) == NULL);
+
+    reader.release = 1;
+    pthread_join(thread, NULL);
+    epoch_synchronize();
+    void *reused = mem_alloc(64);
+    my_assert(reused == block);
+
+    mem_free(reused);
+    mem_free(rest);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Pools of objects smaller than MIN_SIZE can split down to the last one
+void test_min_block()
+{
+    printf_yellow("  Testing mem_set_min_block ---> ");
+#ifdef MEM_DEBUG
+    printf_green("[SKIP] debug blocks carry guard bytes.\n");
+#else
+    void *blocks[4];
+
+    // By default an 8 byte remainder is too small to split off
+    mem_init(32);
+    for (int i = 0; i < 3; i++)
+    {
+        blocks[i] = mem_alloc(8);
+        my_assert(blocks[i] != NULL);
+    }
+    my_assert(mem_alloc(8) == NULL);
+    mem_deinit();
+
+    mem_init(32);
+    my_assert(mem_set_min_block(0) == -1);
+    my_assert(mem_set_min_block(8) == 0);
+    for (int i = 0; i < 4; i++)
+    {
+        blocks[i] = mem_alloc(8);
+        my_assert(blocks[i] != NULL);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        mem_free(blocks[i]);
+    }
+    mem_deinit();
+
+    // Every init starts from the default again
+    mem_init(32);
+    for (int i = 0; i < 3; i++)
+    {
+        my_assert(mem_alloc(8) != NULL);
+    }
+    my_assert(mem_alloc(8) == NULL);
+    mem_deinit();
+    printf_green("[PASS].\n");
+#endif
+}
+
+// Blocks retired before mem_deinit must not be freed into the next pool
+void test_epoch_pool_reinit()
+{
+    printf_yellow("  Testing mem_retire across mem_deinit ---> ");
+    mem_init(1024);
+    void *block = mem_alloc(64);
+    my_assert(block != NULL);
+    mem_retire(block);
+    mem_deinit();
+
+    mem_init(1024);
+    void *all = mem_alloc(1024);
+    my_assert(all != NULL);
+    epoch_synchronize();
+    my_assert(mem_alloc(1) == NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Worker for test_epoch_concurrent: allocates, reads and retires blocks
+static void *epoch_worker(void *arg)
+{
+    int rounds = *(int *)arg;
+    for (int i = 0; i < rounds; i++)
+    {
+        epoch_enter();
+        int *block = mem_alloc(sizeof(int));
+        if (block != NULL)
+        {
+            *block = i;
+        }
+        epoch_exit();
+        mem_retire(block);
+    }
+    epoch_synchronize();
+    return NULL;
+}
+
+void test_epoch_concurrent()
+{
+    printf_yellow("  Testing mem_retire from several threads ---> ");
+    const int nThreads = 4;
+    int rounds = 5000;
+    mem_init(64 * 1024);
+
+    pthread_t threads[nThreads];
+    for (int i = 0; i < nThreads; i++)
+    {
+        pthread_create(&threads[i], NULL, epoch_worker, &rounds);
+    }
+    for (int i = 0; i < nThreads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Every retired block went back to the pool
+    void *all = mem_alloc(64 * 1024);
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_resize_move()
+{
+    printf_yellow("  Testing mem_resize moving a block ---> ");
+    mem_init(1024);
+
+    char *gap = mem_alloc(300);
+    char *block = mem_alloc(100);
+    char *wall = mem_alloc(100); // Stops the block from growing in place
+    my_assert(gap && block && wall);
+    mem_free(gap);
+    memset(block, 'r', 100);
+
+    // Lands in the free space in front of the old block
+    char *moved = mem_resize(block, 200);
+    my_assert(moved == gap);
+    for (int i = 0; i < 100; i++)
+    {
+        my_assert(moved[i] == 'r');
+    }
+
+    // The old space was released and merged with what the split left over
+    char *reuse = mem_alloc(200);
+    my_assert(reuse == moved + 200);
+
+    my_assert(mem_resize(wall, 2048) == NULL); // Does not fit anywhere
+
+    mem_free(reuse);
+    mem_free(moved);
+    mem_free(wall);
+    void *all = mem_alloc(1024);
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Worker for test_resize_concurrent: grows a block step by step while other
+// threads do the same, checking the contents survive every move
+static void *resize_worker(void *arg)
+{
+    long id = (long)arg;
+    int *failed = malloc(sizeof(int));
+    *failed = 0;
+
+    for (int round = 0; round < 50 && !*failed; round++)
+    {
+        size_t size = 16;
+        unsigned char *block = mem_alloc(size);
+        void *wall = mem_alloc(16); // Keep most resizes from growing in place
+        if (block == NULL || wall == NULL)
+        {
+            *failed = 1;
+            break;
+        }
+        memset(block, (int)id, size);
+
+        while (size < 512)
+        {
+            size_t newSize = size * 2;
+            unsigned char *grown = mem_resize(block, newSize);
+            if (grown == NULL)
+            {
+                *failed = 1;
+                break;
+            }
+            for (size_t i = 0; i < size; i++)
+            {
+                if (grown[i] != (unsigned char)id)
+                {
+                    *failed = 1;
+                }
+            }
+            memset(grown, (int)id, newSize);
+            block = grown;
+            size = newSize;
+        }
+        mem_free(block);
+        mem_free(wall);
+    }
+    return failed;
+}
+
+void test_resize_concurrent()
+{
+    printf_yellow("  Testing mem_resize from several threads ---> ");
+    const int nThreads = 4;
+    mem_init(64 * 1024);
+
+    pthread_t threads[nThreads];
+    for (long i = 0; i < nThreads; i++)
+    {
+        pthread_create(&threads[i], NULL, resize_worker, (void *)(i + 1));
+    }
+    for (int i = 0; i < nThreads; i++)
+    {
+        int *failed;
+        pthread_join(threads[i], (void **)&failed);
+        my_assert(*failed == 0);
+        free(failed);
+    }
+
+    void *all = mem_alloc(64 * 1024);
+    my_assert(all != NULL);
+
+    mem_free(all);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+typedef struct
+{
+    void *last;
+    size_t bytes;
+    size_t stopAfter;
+    size_t seen;
+} ForeachArgs;
+
+static int foreach_visit(void *block, size_t size, void *ctx)
+{
+    ForeachArgs *args = ctx;
+    my_assert(args->last == NULL || (char *)block > (char *)args->last);
+    args->last = block;
+    args->bytes += size;
+    args->seen++;
+    return args->seen == args->stopAfter;
+}
+
+void test_foreach_allocated()
+{
+    printf_yellow("  Testing mem_foreach_allocated ---> ");
+    mem_init(4096);
+
+    ForeachArgs args = {NULL, 0, 0, 0};
+    my_assert(mem_foreach_allocated(foreach_visit, &args) == 0);
+
+    void *blocks[8];
+    for (int i = 0; i < 8; i++)
+    {
+        blocks[i] = mem_alloc(64);
+    }
+    // Free every other block and reuse one hole with a smaller block
+    for (int i = 1; i < 8; i += 2)
+    {
+        mem_free(blocks[i]);
+    }
+    void *small = mem_alloc(16);
+    my_assert(small == blocks[1]);
+
+    args = (ForeachArgs){NULL, 0, 0, 0};
+    my_assert(mem_foreach_allocated(foreach_visit, &args) == 5);
+    my_assert(args.bytes == 4 * 64 + 16);
+
+    // Returning nonzero stops the walk
+    args = (ForeachArgs){NULL, 0, 2, 0};
+    my_assert(mem_foreach_allocated(foreach_visit, &args) == 2);
+    my_assert(args.last == small);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_debug_guards()
+{
+    printf_yellow("  Testing MEM_DEBUG guard bytes and double free checks ---> ");
+#ifndef MEM_DEBUG
+    printf_green("[SKIP] needs make test_mmanager_debug.\n");
+#else
+    mem_init(1024);
+    MemDebugStats before, after;
+    mem_debug_stats(&before);
+
+    // New bytes are filled, freed ones poisoned
+    unsigned char *block = mem_alloc(24);
+    for (int i = 0; i < 24; i++)
+    {
+        my_assert(block[i] == 0xCD);
+    }
+    memset(block, 1, 24);
+    my_assert(mem_debug_check() == 0);
+    mem_free(block);
+    for (int i = 0; i < 24; i++)
+    {
+        my_assert(block[i] == 0xDD);
+    }
+
+    // A second free is caught from the header
+    mem_free(block);
+    mem_debug_stats(&after);
+    my_assert(after.double_frees == before.double_frees + 1);
+    my_assert(after.overruns == before.overruns);
+
+    // Writing one byte past the end damages the back guard
+    unsigned char *overrun = mem_alloc(16);
+    overrun[16] = 0;
+    my_assert(mem_debug_check() == 1);
+    mem_free(overrun);
+    mem_debug_stats(&after);
+    my_assert(after.overruns == before.overruns + 1);
+    my_assert(mem_debug_check() == 0);
+
+    // Resizing moves the block and keeps its contents; the old pointer is dead
+    char *small = mem_alloc(8);
+    strcpy(small, "guard");
+    char *grown = mem_resize(small, 64);
+    my_assert(grown != NULL && grown != small && strcmp(grown, "guard") == 0);
+    my_assert(mem_resize(small, 16) == NULL);
+    mem_debug_stats(&after);
+    my_assert(after.invalid_pointers == before.invalid_pointers + 1);
+
+    // The iteration functions report the caller's pointers and sizes
+    void *blocks[2];
+    my_assert(mem_allocated_blocks(blocks, 2) == 1 && blocks[0] == grown);
+
+    // Duplicates within a batch are caught too
+    void *ptrs[2] = {grown, grown};
+    mem_free_batch(ptrs, 2);
+    mem_debug_stats(&after);
+    my_assert(after.double_frees == before.double_frees + 2);
+    my_assert(mem_allocated_blocks(NULL, 0) == 0);
+
+    // Bare batch blocks whose bytes look like a header in front of the next
+    // block are not mistaken for one, whatever state they imitate
+    uint64_t states[2] = {0x4c4956454d454d31ULL, 0x465245454d454d31ULL};  // DEBUG_LIVE, DEBUG_FREED
+    for (int i = 0; i < 2; i++)
+    {
+        char *batch = mem_alloc_batch(2, 64);
+        my_assert(batch != NULL);
+        uint64_t fake[2] = {states[i], 8};
+        memcpy(batch + 64 - 32, fake, sizeof(fake));
+        mem_free(batch + 64);
+        my_assert(mem_allocated_blocks(NULL, 0) == 1);
+        mem_free(batch);
+        my_assert(mem_allocated_blocks(NULL, 0) == 0);
+    }
+    mem_debug_stats(&after);
+    my_assert(after.double_frees == before.double_frees + 2);
+    my_assert(after.invalid_pointers == before.invalid_pointers + 1);
+    my_assert(after.overruns == before.overruns + 1);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+#endif
+}
+
+__attribute__((noinline)) static void *profile_site_a(size_t size)
+{
+    return mem_alloc(size);
+}
+
+__attribute__((noinline)) static void *profile_site_b(size_t size)
+{
+    return mem_alloc(size);
+}
+
+void test_profile_sites()
+{
+    printf_yellow("  Testing allocation call site profiling ---> ");
+    mem_init(1 << 20);
+    my_assert(mem_profile_start(0) == -1);
+
+    // Sample every allocation so the counts are exact
+    my_assert(mem_profile_start(1) == 0);
+    void *a[10];
+    void *b[5];
+    for (int i = 0; i < 10; i++)
+    {
+        a[i] = profile_site_a(64);
+    }
+    for (int i = 0; i < 5; i++)
+    {
+        b[i] = profile_site_b(128);
+    }
+    for (int i = 0; i < 5; i++)
+    {
+        mem_free(a[i]);
+    }
+    // A resized block stays with the site it came from
+    b[0] = mem_resize(b[0], 256);
+
+    MemProfileSite sites[8];
+    my_assert(mem_profile_sites(sites, 8) == 2);
+    MemProfileSite *siteA = sites[0].total_count == 10 ? &sites[0] : &sites[1];
+    MemProfileSite *siteB = sites[0].total_count == 10 ? &sites[1] : &sites[0];
+    my_assert(siteA->total_count == 10 && siteA->live_count == 5);
+    my_assert(siteA->total_bytes == 640 && siteA->live_bytes == 320);
+    my_assert(siteB->total_count == 5 && siteB->live_count == 5);
+    my_assert(siteB->live_bytes == 4 * 128 + 256);
+    my_assert(siteA->frames[0] != siteB->frames[0]);
+
+    // One line per site after the header
+    char path[] = "/tmp/mem_profile_XXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    my_assert(mem_profile_dump(fd) == 0);
+    char text[4096];
+    ssize_t len = pread(fd, text, sizeof(text) - 1, 0);
+    my_assert(len > 0);
+    text[len] = '\0';
+    int lines = 0;
+    for (ssize_t i = 0; i < len; i++)
+    {
+        lines += text[i] == '\n';
+    }
+    my_assert(strncmp(text, "# mem_profile sample_bytes=1 sites=2", 36) == 0 && lines == 3);
+    close(fd);
+    unlink(path);
+
+    // Resetting the pool drops the live samples
+    mem_deinit();
+    mem_init(1 << 20);
+    my_assert(mem_profile_sites(sites, 8) == 2);
+    my_assert(sites[0].live_count == 0 && sites[1].live_count == 0);
+
+    // With sampling, the estimate lands near the real total
+    my_assert(mem_profile_start(4096) == 0);
+    for (int i = 0; i < 10000; i++)
+    {
+        profile_site_a(64);
+    }
+    my_assert(mem_profile_sites(sites, 8) == 1);
+    my_assert(sites[0].live_bytes > 640000 * 3 / 4 && sites[0].live_bytes < 640000 * 5 / 4);
+    my_assert(sites[0].total_count < 10000 / 20);
+
+    mem_profile_stop();
+    my_assert(mem_profile_sites(sites, 8) == 0);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_dump_map()
+{
+    printf_yellow("  Testing heap map export ---> ");
+    mem_init(1024);
+    void *a = mem_alloc(100);
+    void *b = mem_alloc(200);
+    void *c = mem_alloc(300);
+    mem_free(b);
+    mem_handle_t handle = mem_handle_alloc(50);
+    (void)a;
+    (void)c;
+
+    // CSV rows follow the blocks in address order
+    char path[] = "/tmp/mem_map_XXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    my_assert(mem_dump_map(fd, MEM_MAP_CSV) == 0);
+    char text[1024];
+    ssize_t len = pread(fd, text, sizeof(text) - 1, 0);
+    my_assert(len > 0);
+    text[len] = '\0';
+    my_assert(strncmp(text, "# mem_map timestamp_ns=", 23) == 0);
+    my_assert(strstr(text, "pool_size=1024 blocks=5\noffset,size,state\n"
+                           "0,100,used\n100,50,handle\n150,150,free\n300,300,used\n600,424,free\n") != NULL);
+
+    // A binary snapshot appended after it: header plus one record per block
+    off_t start = lseek(fd, 0, SEEK_END);
+    my_assert(mem_dump_map(fd, MEM_MAP_BINARY) == 0);
+    MemMapHeader header;
+    my_assert(pread(fd, &header, sizeof(header), start) == sizeof(header));
+    my_assert(header.magic == MEM_MAP_MAGIC && header.version == MEM_MAP_VERSION);
+    my_assert(header.pool_size == 1024 && header.block_count == 5);
+    uint64_t records[5];
+    my_assert(pread(fd, records, sizeof(records), start + sizeof(header)) == sizeof(records));
+    my_assert(records[0] == (100 << 2 | MEM_MAP_USED) && records[1] == (50 << 2 | MEM_MAP_HANDLE));
+    my_assert(records[2] == (150 << 2 | MEM_MAP_FREE) && records[4] == (424 << 2 | MEM_MAP_FREE));
+    my_assert(lseek(fd, 0, SEEK_END) == start + (off_t)(sizeof(header) + sizeof(records)));
+
+    close(fd);
+    unlink(path);
+    mem_handle_free(handle);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void *trace_worker(void *arg)
+{
+    size_t base = (size_t)arg;
+    for (size_t i = 0; i < 50; i++)
+    {
+        void *block = mem_alloc(base + i);
+        my_assert(block != NULL);
+        mem_free(block);
+    }
+    return NULL;
+}
+
+void test_trace_record()
+{
+    printf_yellow("  Testing allocation tracing ---> ");
+    char path[] = "/tmp/mem_trace_XXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    my_assert(mem_trace_start(fd) == 0);
+    my_assert(mem_trace_start(fd) == -1);
+
+    // Traffic from two threads and the main thread
+    mem_init(8192);
+    pthread_t threads[2];
+    for (size_t t = 0; t < 2; t++)
+    {
+        pthread_create(&threads[t], NULL, trace_worker, (void *)(16 + 100 * t));
+    }
+    void *block = mem_alloc(40);
+    void *batch = mem_alloc_batch(4, 32);
+    my_assert(block != NULL && batch != NULL);
+    block = mem_resize(block, 200);
+    my_assert(block != NULL);
+    mem_free(batch);
+    mem_free((char *)batch + 32);
+    void *rest[] = {(char *)batch + 96, (char *)batch + 64};
+    mem_free_batch(rest, 2);
+    mem_free(block);
+    // Sizes past 32 bits are recorded whole, even when the request fails
+    uint64_t huge = (uint64_t)5 << 32;
+    my_assert(mem_alloc(huge) == NULL);
+    for (size_t t = 0; t < 2; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    mem_trace_stop();
+    mem_alloc(10); // Not traced any more
+
+    MemTraceHeader header;
+    my_assert(pread(fd, &header, sizeof(header), 0) == sizeof(header));
+    my_assert(header.magic == MEM_TRACE_MAGIC && header.version == MEM_TRACE_VERSION);
+    MemTraceRecord records[256];
+    ssize_t len = pread(fd, records, sizeof(records), sizeof(header));
+    my_assert(len > 0 && len % sizeof(MemTraceRecord) == 0);
+    size_t count = (size_t)len / sizeof(MemTraceRecord);
+
+    // Sequence numbers are unique and every free matches a live block
+    size_t ops[MEM_TRACE_RESIZE + 1] = {0};
+    size_t failed = 0;
+    uint64_t live[16];
+    size_t liveCount = 0;
+    uint64_t first = UINT64_MAX;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (records[i].sequence < first)
+            first = records[i].sequence;
+    }
+    for (uint64_t sequence = first; sequence < first + count; sequence++)
+    {
+        MemTraceRecord *record = NULL;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (records[i].sequence == sequence)
+            {
+                my_assert(record == NULL);
+                record = &records[i];
+            }
+        }
+        my_assert(record != NULL);
+        my_assert(record->op >= MEM_TRACE_INIT && record->op <= MEM_TRACE_RESIZE);
+        ops[record->op]++;
+        if (sequence == first)
+            my_assert(record->op == MEM_TRACE_INIT && record->size == mem_pool_size());
+
+        if (record->op == MEM_TRACE_FREE || record->op == MEM_TRACE_RESIZE)
+        {
+            size_t j = 0;
+            while (j < liveCount && live[j] != record->block)
+                j++;
+            my_assert(j < liveCount);
+            live[j] = live[--liveCount];
+        }
+        if (record->op == MEM_TRACE_ALLOC && record->block == MEM_TRACE_NONE)
+        {
+            my_assert(record->size == huge);
+            failed++;
+        }
+        else if (record->op == MEM_TRACE_ALLOC || record->op == MEM_TRACE_RESIZE)
+            live[liveCount++] = record->op == MEM_TRACE_ALLOC ? record->block : record->result;
+        if (record->op == MEM_TRACE_BATCH)
+        {
+            my_assert(record->result == 4 && record->size == 32);
+            for (uint64_t k = 0; k < record->result; k++)
+                live[liveCount++] = record->block + k * record->size;
+        }
+        my_assert(liveCount < 16);
+    }
+    my_assert(liveCount == 0);
+    my_assert(ops[MEM_TRACE_INIT] == 1 && ops[MEM_TRACE_BATCH] == 1 && failed == 1);
+#ifndef MEM_DEBUG
+    // The debug build moves every resized block, which is traced as alloc and free
+    my_assert(ops[MEM_TRACE_ALLOC] == 102 && ops[MEM_TRACE_FREE] == 105 && ops[MEM_TRACE_RESIZE] == 1);
+#endif
+
+    close(fd);
+    unlink(path);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_numa_pool()
+{
+    printf_yellow("  Testing NUMA node pools ---> ");
+    cpu_set_t affinity;
+    sched_getaffinity(0, sizeof(affinity), &affinity);
+    int nodes = mem_init_numa(1 << 20);
+    my_assert(nodes >= 1 && mem_numa_nodes() == nodes);
+
+    // Every node's allocations come from its own region
+    for (int node = 0; node < nodes; node++)
+    {
+        my_assert(mem_numa_run_on_node(node) == 0);
+        void *block = mem_alloc(100);
+        void *batch = mem_alloc_batch(4, 64);
+        my_assert(block != NULL && batch != NULL);
+        my_assert(mem_numa_node_of(block) == node && mem_numa_node_of(batch) == node);
+        block = mem_resize(block, 1000); // The batch is in the way, so it moves
+        my_assert(block != NULL && mem_numa_node_of(block) == node);
+        mem_free(block);
+        for (size_t k = 0; k < 4; k++)
+        {
+            mem_free((char *)batch + k * 64);
+        }
+    }
+    my_assert(mem_numa_run_on_node(nodes) == -1);
+    sched_setaffinity(0, sizeof(affinity), &affinity);
+    int outside;
+    my_assert(mem_numa_node_of(&outside) == -1);
+
+    // A full node falls back to the others, and freeing merges everything again
+    void *blocks[64];
+    size_t count = 0;
+    while (count < 64 && (blocks[count] = mem_alloc((1 << 20) / 64)) != NULL)
+    {
+        count++;
+    }
+    my_assert(count >= 63);
+    for (size_t i = 0; i < count; i++)
+    {
+        mem_free(blocks[i]);
+    }
+    MemFreeStats stats;
+    mem_free_stats(&stats);
+    my_assert(stats.free_blocks == 1 && stats.largest_free == mem_pool_size());
+
+    // Other pools have no nodes
+    mem_deinit();
+    mem_init(1024);
+    my_assert(mem_numa_nodes() == 0 && mem_numa_node_of(mem_pool_base()) == -1);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef VERSION
@@ -362,7 +1326,43 @@ int main(int argc, char *argv[])
 	
 	printf("\nVarious tests: \n");
 	printf(" 17. test_zero_alloc_and_free - Ensure that we can allocate 0 bytes, and it does not fail.\n");
-	printf(" 18. test_random_blocks - Test that we can allocate a random size, and random amounts of blocks [1000,10000]. \n\n");
+	printf(" 18. test_random_blocks - Test that we can allocate a random size, and random amounts of blocks [1000,10000]. \n");
+
+        printf("\nRelocatable handles:\n");
+        printf(" 19. test_handle_lock_unlock - Test handle allocation, locking and freeing\n");
+        printf(" 20. test_compaction - Test that mem_compact merges fragmented free space\n");
+        printf(" 21. test_compaction_pinned - Test that plain and locked blocks are not moved\n");
+
+        printf("\nBatch allocation:\n");
+        printf(" 22. test_alloc_batch - Test allocating many contiguous blocks at once\n");
+        printf(" 36. test_min_block - Test splitting down to blocks smaller than MIN_SIZE\n");
+
+        printf("\nShared memory:\n");
+        printf(" 23. test_shared_pool - Test two processes allocating from one shared pool\n");
+
+        printf("\nDeferred reclamation:\n");
+        printf(" 24. test_free_batch - Test freeing many blocks under one lock\n");
+        printf(" 25. test_epoch_deferred_free - Test retired blocks wait for active readers\n");
+        printf(" 26. test_epoch_concurrent - Test retiring blocks from several threads\n");
+        printf(" 35. test_epoch_pool_reinit - Test retired blocks do not outlive their pool\n");
+
+        printf("\nResizing:\n");
+        printf(" 27. test_resize_move - Test a resize that has to move the block\n");
+        printf(" 28. test_resize_concurrent - Test growing resizes from several threads\n");
+
+        printf("\nPool iteration:\n");
+        printf(" 29. test_foreach_allocated - Test visiting allocated blocks in address order\n");
+
+        printf("\nDebug build:\n");
+        printf(" 30. test_debug_guards - Test guard bytes, poisoning and double free checks (make test_mmanager_debug)\n");
+
+        printf("\nHeap profiling:\n");
+        printf(" 31. test_profile_sites - Test sampling allocations by call site\n");
+        printf(" 32. test_dump_map - Test exporting the block layout as CSV and binary\n");
+        printf(" 33. test_trace_record - Test tracing allocations from several threads\n");
+
+        printf("\nNUMA pools:\n");
+        printf(" 34. test_numa_pool - Test allocating from the caller's node region\n\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -399,6 +1399,42 @@ int main(int argc, char *argv[])
         printf("\nVarious other tests:\n");
         test_zero_alloc_and_free();
         test_random_blocks();
+
+        printf("\nTesting Relocatable Handles:\n");
+        test_handle_lock_unlock();
+        test_compaction();
+        test_compaction_pinned();
+
+        printf("\nTesting Batch Allocation:\n");
+        test_alloc_batch();
+        test_min_block();
+
+        printf("\nTesting Shared Memory:\n");
+        test_shared_pool();
+
+        printf("\nTesting Deferred Reclamation:\n");
+        test_free_batch();
+        test_epoch_deferred_free();
+        test_epoch_concurrent();
+        test_epoch_pool_reinit();
+
+        printf("\nTesting Resizing:\n");
+        test_resize_move();
+        test_resize_concurrent();
+
+        printf("\nTesting Pool Iteration:\n");
+        test_foreach_allocated();
+
+        printf("\nTesting Debug Build:\n");
+        test_debug_guards();
+
+        printf("\nTesting Heap Profiling:\n");
+        test_profile_sites();
+        test_dump_map();
+        test_trace_record();
+
+        printf("\nTesting NUMA Pools:\n");
+        test_numa_pool();
         break;
     case 1:
         test_init();
@@ -454,6 +1490,60 @@ int main(int argc, char *argv[])
     case 18:
         test_random_blocks();
         break;
+    case 19:
+        test_handle_lock_unlock();
+        break;
+    case 20:
+        test_compaction();
+        break;
+    case 21:
+        test_compaction_pinned();
+        break;
+    case 22:
+        test_alloc_batch();
+        break;
+    case 23:
+        test_shared_pool();
+        break;
+    case 24:
+        test_free_batch();
+        break;
+    case 25:
+        test_epoch_deferred_free();
+        break;
+    case 26:
+        test_epoch_concurrent();
+        break;
+    case 27:
+        test_resize_move();
+        break;
+    case 28:
+        test_resize_concurrent();
+        break;
+    case 29:
+        test_foreach_allocated();
+        break;
+    case 30:
+        test_debug_guards();
+        break;
+    case 31:
+        test_profile_sites();
+        break;
+    case 32:
+        test_dump_map();
+        break;
+    case 33:
+        test_trace_record();
+        break;
+    case 34:
+        test_numa_pool();
+        break;
+    case 35:
+        test_epoch_pool_reinit();
+        break;
+    case 36:
+        test_min_block();
+        break;
     default:
         printf("Invalid test function\n");
         break;
@@ -0,0 +1,199 @@
+#include "memory_manager.h"
+#include "skip_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Capture what skiplist_display_range writes to stdout
+void capture_display_range(char *buffer, size_t size, SkipList *list, uint16_t low, uint16_t high)
+{
+    FILE *tempFile = fopen("temp_output.txt", "w+");
+    if (tempFile == NULL)
+    {
+        printf("Failed to open temporary file for capturing stdout.\n");
+        return;
+    }
+
+    FILE *original_stdout = stdout;
+    stdout = tempFile;
+    skiplist_display_range(list, low, high);
+    fflush(stdout);
+    stdout = original_stdout;
+
+    rewind(tempFile);
+    size_t n = fread(buffer, 1, size - 1, tempFile);
+    buffer[n] = '\0';
+    fclose(tempFile);
+}
+
+// ********* Test basic skip list operations *********
+
+void test_skiplist_insert_search()
+{
+    printf_yellow("  Testing skiplist_insert and skiplist_search ---> ");
+    SkipList list;
+    my_assert(skiplist_init(&list, 4) == 0);
+    skiplist_insert(&list, 30);
+    skiplist_insert(&list, 10);
+    skiplist_insert(&list, 20);
+
+    my_assert(skiplist_count(&list) == 3);
+    my_assert(skiplist_search(&list, 20)->data == 20);
+    my_assert(skiplist_search(&list, 25) == NULL);
+
+    // Level 0 is the ordered list
+    SkipNode *node = skiplist_lower_bound(&list, 0);
+    my_assert(node->data == 10);
+    my_assert(skiplist_next(node)->data == 20);
+    my_assert(skiplist_next(skiplist_next(node))->data == 30);
+
+    skiplist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_skiplist_delete()
+{
+    printf_yellow("  Testing skiplist_delete ---> ");
+    SkipList list;
+    my_assert(skiplist_init(&list, 4) == 0);
+    skiplist_insert(&list, 10);
+    skiplist_insert(&list, 20);
+    skiplist_insert(&list, 20);
+
+    skiplist_delete(&list, 20);
+    my_assert(skiplist_count(&list) == 2);
+    my_assert(skiplist_search(&list, 20) != NULL); // One duplicate remains
+    skiplist_delete(&list, 20);
+    my_assert(skiplist_search(&list, 20) == NULL);
+    skiplist_delete(&list, 10);
+    my_assert(skiplist_count(&list) == 0);
+    my_assert(skiplist_lower_bound(&list, 0) == NULL);
+
+    skiplist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_skiplist_display_range()
+{
+    printf_yellow("  Testing skiplist_display_range ---> ");
+    SkipList list;
+    my_assert(skiplist_init(&list, 5) == 0);
+    skiplist_insert(&list, 40);
+    skiplist_insert(&list, 10);
+    skiplist_insert(&list, 30);
+    skiplist_insert(&list, 20);
+    skiplist_insert(&list, 50);
+
+    char buffer[256];
+    capture_display_range(buffer, sizeof(buffer), &list, 0, 65535);
+    my_assert(strcmp(buffer, "[10, 20, 30, 40, 50]") == 0);
+    capture_display_range(buffer, sizeof(buffer), &list, 15, 40);
+    my_assert(strcmp(buffer, "[20, 30, 40]") == 0);
+    capture_display_range(buffer, sizeof(buffer), &list, 41, 49);
+    my_assert(strcmp(buffer, "[]") == 0);
+
+    skiplist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_skiplist_random_loop(int count)
+{
+    printf_yellow("  Testing skiplist random insert and delete loop ---> ");
+    SkipList list;
+    my_assert(skiplist_init(&list, count) == 0);
+
+    uint16_t values[count];
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = rand() % 1000;
+        skiplist_insert(&list, values[i]);
+    }
+    my_assert(skiplist_count(&list) == (size_t)count);
+
+    // The bottom level must be sorted
+    int n = 0;
+    for (SkipNode *node = skiplist_lower_bound(&list, 0); node != NULL; node = skiplist_next(node))
+    {
+        my_assert(skiplist_next(node) == NULL || node->data <= skiplist_next(node)->data);
+        n++;
+    }
+    my_assert(n == count);
+
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(skiplist_search(&list, values[i]) != NULL);
+        skiplist_delete(&list, values[i]);
+    }
+    my_assert(skiplist_count(&list) == 0);
+
+    skiplist_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+    srand(time(NULL));
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_skiplist_insert_search - Test ordered insert and search\n");
+        printf(" 2. test_skiplist_delete - Test delete by value\n");
+        printf(" 3. test_skiplist_display_range - Test displaying a value range\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 4. test_skiplist_random_loop - Test many random inserts and deletes\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_skiplist_insert_search();
+        test_skiplist_delete();
+        test_skiplist_display_range();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_skiplist_random_loop(1000);
+        break;
+    case 1:
+        test_skiplist_insert_search();
+        break;
+    case 2:
+        test_skiplist_delete();
+        break;
+    case 3:
+        test_skiplist_display_range();
+        break;
+    case 4:
+        test_skiplist_random_loop(1000);
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
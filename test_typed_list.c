@@ -0,0 +1,166 @@
+#include "memory_manager.h"
+#include "typed_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// A small struct element compared field by field
+typedef struct
+{
+    uint32_t id;
+    float weight;
+} Item;
+
+static inline int item_eq(Item a, Item b)
+{
+    return a.id == b.id && a.weight == b.weight;
+}
+
+DEFINE_LIST(u8, uint8_t)
+DEFINE_LIST(u64, uint64_t)
+DEFINE_LIST_EQ(item, Item, item_eq)
+
+// ********* Test basic typed list operations *********
+
+void test_typed_node_layout()
+{
+    printf_yellow("  Testing node layouts per element type ---> ");
+    // The element is stored inline, so the node only grows with the type
+    my_assert(sizeof(u8_node) == 2 * sizeof(void *));
+    my_assert(sizeof(u64_node) == 16);
+    my_assert(offsetof(u64_node, data) == 0);
+    my_assert(sizeof(item_node) == sizeof(Item) + sizeof(void *));
+    printf_green("[PASS].\n");
+}
+
+void test_typed_u64()
+{
+    printf_yellow("  Testing a list of uint64_t ---> ");
+    u64_list list;
+    u64_list_init(&list, 4);
+
+    const uint64_t big = 0xFEDCBA9876543210ull;
+    u64_list_insert(&list, 2);
+    u64_list_insert(&list, big);
+    u64_list_push_front(&list, 1);
+    u64_list_insert_after(&list, u64_list_search(&list, big), 4);
+
+    uint64_t expected[] = {1, 2, big, 4};
+    int i = 0;
+    for (u64_node *node = list.head; node != NULL; node = node->next)
+    {
+        my_assert(node->data == expected[i]);
+        i++;
+    }
+    my_assert(i == 4 && u64_list_count(&list) == 4);
+    my_assert(list.tail->data == 4);
+
+    my_assert(u64_list_delete(&list, big) == 0);
+    my_assert(u64_list_delete(&list, big) == -1);
+    my_assert(u64_list_search(&list, big) == NULL);
+    my_assert(u64_list_delete(&list, 4) == 0); // Tail moves back
+    my_assert(list.tail->data == 2);
+    u64_list_insert(&list, 5);
+    my_assert(list.tail->data == 5 && u64_list_count(&list) == 3);
+
+    u64_list_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_typed_struct()
+{
+    printf_yellow("  Testing a list of structs with a custom equality ---> ");
+    item_list list;
+    item_list_init(&list, 3);
+
+    item_list_insert(&list, (Item){1, 0.5f});
+    item_list_insert(&list, (Item){2, 1.5f});
+    item_list_insert(&list, (Item){1, 2.5f});
+
+    item_node *found = item_list_search(&list, (Item){1, 2.5f});
+    my_assert(found != NULL && found == list.tail);
+    my_assert(item_list_search(&list, (Item){3, 0.5f}) == NULL);
+
+    my_assert(item_list_delete(&list, (Item){1, 0.5f}) == 0);
+    my_assert(list.head->data.id == 2);
+    my_assert(item_list_count(&list) == 2);
+
+    item_list_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_typed_u8_empty()
+{
+    printf_yellow("  Testing an emptied list of uint8_t ---> ");
+    u8_list list;
+    u8_list_init(&list, 2);
+
+    my_assert(u8_list_delete(&list, 7) == -1);
+    u8_list_insert(&list, 7);
+    my_assert(u8_list_delete(&list, 7) == 0);
+    my_assert(list.head == NULL && list.tail == NULL);
+    u8_list_push_front(&list, 9);
+    my_assert(list.head == list.tail && list.tail->data == 9);
+
+    u8_list_cleanup(&list);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_typed_node_layout - Check node sizes per element type\n");
+        printf(" 2. test_typed_u64 - Test a list of 64 bit values\n");
+        printf(" 3. test_typed_struct - Test a list of structs\n");
+        printf(" 4. test_typed_u8_empty - Test head and tail when the list empties\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_typed_node_layout();
+        test_typed_u64();
+        test_typed_struct();
+        test_typed_u8_empty();
+        break;
+    case 1:
+        test_typed_node_layout();
+        break;
+    case 2:
+        test_typed_u64();
+        break;
+    case 3:
+        test_typed_struct();
+        break;
+    case 4:
+        test_typed_u8_empty();
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
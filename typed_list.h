@@ -0,0 +1,170 @@
+#ifndef TYPED_LIST_H
+#define TYPED_LIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "memory_manager.h"
+
+// Typed linked lists generated per element type. DEFINE_LIST(u64, uint64_t)
+// expands to a u64_node holding the value inline, a u64_list and static
+// inline u64_list_* functions, so each element type gets its own node layout
+// and operations the compiler can inline, without void* payloads or
+// comparison callbacks.
+//
+// DEFINE_LIST compares elements with ==. Types without == such as structs
+// use DEFINE_LIST_EQ(name, type, eq), where eq(a, b) is a macro or an
+// inline function returning nonzero for equal values.
+//
+// Like the other lists, name##_list_init sets up the memory pool with room
+// for size nodes.
+
+#define TYPED_LIST_SCALAR_EQ(a, b) ((a) == (b))
+
+#define DEFINE_LIST(name, type) DEFINE_LIST_EQ(name, type, TYPED_LIST_SCALAR_EQ)
+
+#define DEFINE_LIST_EQ(name, type, eq)                                              \
+                                                                                    \
+typedef struct name##_node {                                                        \
+    type data;                                                                      \
+    struct name##_node* next;                                                       \
+} name##_node;                                                                      \
+                                                                                    \
+typedef struct {                                                                    \
+    name##_node* head;                                                              \
+    name##_node* tail;                                                              \
+    size_t count;                                                                   \
+    pthread_mutex_t mutex;                                                          \
+} name##_list;                                                                      \
+                                                                                    \
+/* Initialize the list and a memory pool for size elements */                       \
+static inline void name##_list_init(name##_list* list, size_t size) {              \
+    mem_init(sizeof(name##_node) * size);                                           \
+    pthread_mutex_init(&list->mutex, NULL);                                         \
+    list->head = NULL;                                                              \
+    list->tail = NULL;                                                              \
+    list->count = 0;                                                                \
+}                                                                                   \
+                                                                                    \
+/* Allocate and fill a node before taking the list mutex */                         \
+static inline name##_node* name##_new_node(type data) {                             \
+    name##_node* node = (name##_node*)mem_alloc(sizeof(name##_node));               \
+    if (node == NULL) {                                                             \
+        printf("Error: Memory allocation failed.\n");                               \
+        return NULL;                                                                \
+    }                                                                               \
+    node->data = data;                                                              \
+    node->next = NULL;                                                              \
+    return node;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Insert a new node at the end of the list */                                      \
+static inline name##_node* name##_list_insert(name##_list* list, type data) {       \
+    name##_node* node = name##_new_node(data);                                      \
+    if (node == NULL) return NULL;                                                  \
+                                                                                    \
+    pthread_mutex_lock(&list->mutex);  /* Lock the mutex */                         \
+    if (list->tail != NULL) list->tail->next = node; else list->head = node;        \
+    list->tail = node;                                                              \
+    list->count++;                                                                  \
+    pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                     \
+    return node;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Insert a new node at the front of the list */                                    \
+static inline name##_node* name##_list_push_front(name##_list* list, type data) {   \
+    name##_node* node = name##_new_node(data);                                      \
+    if (node == NULL) return NULL;                                                  \
+                                                                                    \
+    pthread_mutex_lock(&list->mutex);  /* Lock the mutex */                         \
+    node->next = list->head;                                                        \
+    list->head = node;                                                              \
+    if (list->tail == NULL) list->tail = node;                                      \
+    list->count++;                                                                  \
+    pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                     \
+    return node;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Insert a new node after a given node */                                          \
+static inline name##_node* name##_list_insert_after(name##_list* list,              \
+                                                    name##_node* prev_node,         \
+                                                    type data) {                    \
+    if (prev_node == NULL) {                                                        \
+        printf("Error: Previous node cannot be NULL.\n");                           \
+        return NULL;                                                                \
+    }                                                                               \
+    name##_node* node = name##_new_node(data);                                      \
+    if (node == NULL) return NULL;                                                  \
+                                                                                    \
+    pthread_mutex_lock(&list->mutex);  /* Lock the mutex */                         \
+    node->next = prev_node->next;                                                   \
+    prev_node->next = node;                                                         \
+    if (list->tail == prev_node) list->tail = node;                                 \
+    list->count++;                                                                  \
+    pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                     \
+    return node;                                                                    \
+}                                                                                   \
+                                                                                    \
+/* Delete the first node equal to data. Returns 0 on success, -1 if absent. */      \
+static inline int name##_list_delete(name##_list* list, type data) {                \
+    pthread_mutex_lock(&list->mutex);  /* Lock the mutex */                         \
+                                                                                    \
+    name##_node* previous = NULL;                                                   \
+    name##_node* current = list->head;                                              \
+    while (current != NULL && !eq(current->data, data)) {                           \
+        previous = current;                                                         \
+        current = current->next;                                                    \
+    }                                                                               \
+    if (current == NULL) {                                                          \
+        pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                 \
+        return -1;                                                                  \
+    }                                                                               \
+                                                                                    \
+    if (previous != NULL) previous->next = current->next;                           \
+    else list->head = current->next;                                                \
+    if (list->tail == current) list->tail = previous;                               \
+    list->count--;                                                                  \
+                                                                                    \
+    pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                     \
+    mem_free(current);                                                              \
+    return 0;                                                                       \
+}                                                                                   \
+                                                                                    \
+/* Search for the first node equal to data */                                       \
+static inline name##_node* name##_list_search(name##_list* list, type data) {       \
+    pthread_mutex_lock(&list->mutex);  /* Lock the mutex */                         \
+    name##_node* current = list->head;                                              \
+    while (current != NULL && !eq(current->data, data)) {                           \
+        current = current->next;                                                    \
+    }                                                                               \
+    pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                     \
+    return current;                                                                 \
+}                                                                                   \
+                                                                                    \
+/* Count the elements in the list */                                                \
+static inline size_t name##_list_count(name##_list* list) {                         \
+    pthread_mutex_lock(&list->mutex);  /* Lock the mutex */                         \
+    size_t count = list->count;                                                     \
+    pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                     \
+    return count;                                                                   \
+}                                                                                   \
+                                                                                    \
+/* Clean up the list */                                                             \
+static inline void name##_list_cleanup(name##_list* list) {                         \
+    pthread_mutex_lock(&list->mutex);  /* Lock the mutex */                         \
+    name##_node* current = list->head;                                              \
+    list->head = NULL;                                                              \
+    list->tail = NULL;                                                              \
+    list->count = 0;                                                                \
+    pthread_mutex_unlock(&list->mutex);  /* Unlock the mutex */                     \
+                                                                                    \
+    while (current != NULL) {                                                       \
+        name##_node* next = current->next;                                          \
+        mem_free(current);                                                          \
+        current = next;                                                             \
+    }                                                                               \
+    pthread_mutex_destroy(&list->mutex);                                            \
+}
+
+#endif // TYPED_LIST_H